@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// minimal benchmark harness in the spirit of Google Benchmark: every benchmark is warmed up, then
+// run with a doubling iteration count until one run lasts --min-time, and repeated --repetitions
+// times; the median repetition is reported, optionally as JSON for regression tracking
+namespace blitz_bench
+{
+    template <typename T>
+    inline void doNotOptimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void clobberMemory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    // pin the calling thread, returns false where affinity is not supported
+    inline bool pinToCpu(int cpu)
+    {
+#ifdef __linux__
+        if (cpu < 0)
+            return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    class State
+    {
+    public:
+        State(size_t iterations, int cpu) : remaining(iterations), total(iterations), pinnedCpu(cpu) {}
+
+        // while (state.keepRunning()) { ...measured code... }
+        bool keepRunning()
+        {
+            if (remaining == total)
+                start = std::chrono::steady_clock::now();
+            if (remaining-- > 0)
+                return true;
+            elapsed += std::chrono::steady_clock::now() - start;
+            return false;
+        }
+
+        // exclude setup inside the loop from the measurement
+        void pauseTiming() { elapsed += std::chrono::steady_clock::now() - start; }
+        void resumeTiming() { start = std::chrono::steady_clock::now(); }
+
+        // for benchmarks timing themselves, e.g. across threads
+        void setElapsed(std::chrono::nanoseconds time) { manualElapsed = time; }
+
+        void setItemsProcessed(uint64_t items) { itemsProcessed = items; }
+        void setBytesProcessed(uint64_t bytes) { bytesProcessed = bytes; }
+
+        size_t iterations() const { return total; }
+        int cpu() const { return pinnedCpu; } // -1 when not pinned
+
+        std::chrono::nanoseconds measured() const
+        {
+            if (manualElapsed.count() > 0)
+                return manualElapsed;
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+        }
+        uint64_t items() const { return itemsProcessed ? itemsProcessed : total; }
+        uint64_t bytes() const { return bytesProcessed; }
+
+    private:
+        size_t remaining;
+        size_t total;
+        int pinnedCpu;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration elapsed{0};
+        std::chrono::nanoseconds manualElapsed{0};
+        uint64_t itemsProcessed{0};
+        uint64_t bytesProcessed{0};
+    };
+
+    struct Benchmark
+    {
+        std::string name;
+        std::function<void(State &)> run;
+        size_t maxIterations; // caps benchmarks with side effects, like rotations
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t iterations;
+        double nsPerItem;
+        double itemsPerSecond;
+        double bytesPerSecond;
+    };
+
+    inline std::vector<Benchmark> &registry()
+    {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    inline void add(std::string name, std::function<void(State &)> run, size_t maxIterations = SIZE_MAX)
+    {
+        registry().push_back({std::move(name), std::move(run), maxIterations});
+    }
+
+    struct Options
+    {
+        std::string filter;
+        std::string jsonPath;
+        double minTime{0.5}; // seconds per measured run
+        int repetitions{3};
+        int cpu{-1};
+    };
+
+    inline Result runOne(const Benchmark &benchmark, const Options &options)
+    {
+        auto once = [&](size_t iterations)
+        {
+            State state(iterations, options.cpu);
+            benchmark.run(state);
+            return state;
+        };
+
+        // warmup doubles as calibration of the iteration count
+        size_t iterations = 1;
+        State state = once(iterations);
+        while (state.measured() < std::chrono::duration<double>(options.minTime) && iterations < benchmark.maxIterations)
+        {
+            double seconds = std::max(std::chrono::duration<double>(state.measured()).count(), 1e-9);
+            size_t next = static_cast<size_t>(static_cast<double>(iterations) * options.minTime * 1.4 / seconds);
+            iterations = std::min({std::max(next, iterations * 2), iterations * 100, benchmark.maxIterations});
+            state = once(iterations);
+        }
+
+        std::vector<Result> runs;
+        for (int i = 0; i < options.repetitions; ++i)
+        {
+            State measured = once(iterations);
+            double ns = static_cast<double>(measured.measured().count());
+            double seconds = ns / 1e9;
+            runs.push_back({benchmark.name, iterations, ns / static_cast<double>(measured.items()),
+                            static_cast<double>(measured.items()) / seconds,
+                            static_cast<double>(measured.bytes()) / seconds});
+        }
+
+        std::sort(runs.begin(), runs.end(), [](const Result &a, const Result &b)
+                  { return a.nsPerItem < b.nsPerItem; });
+        return runs[runs.size() / 2];
+    }
+
+    inline void writeJson(const std::string &path, const Options &options, const std::vector<Result> &results)
+    {
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        std::ofstream out(path);
+        out << std::format("{{\n  \"context\": {{\"date\": \"{}\", \"num_cpus\": {}, \"pinned_cpu\": {}, "
+                           "\"min_time\": {}, \"repetitions\": {}}},\n  \"benchmarks\": [\n",
+                           date, std::thread::hardware_concurrency(), options.cpu, options.minTime, options.repetitions);
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto &r = results[i];
+            out << std::format("    {{\"name\": \"{}\", \"iterations\": {}, \"real_time\": {:.3f}, \"time_unit\": \"ns\", "
+                               "\"items_per_second\": {:.1f}, \"bytes_per_second\": {:.1f}}}{}\n",
+                               r.name, r.iterations, r.nsPerItem, r.itemsPerSecond, r.bytesPerSecond,
+                               i + 1 < results.size() ? "," : "");
+        }
+        out << "  ]\n}\n";
+    }
+
+    inline int runMain(int argc, char *argv[])
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+            auto value = [&]() -> std::string
+            { return i + 1 < argc ? argv[++i] : ""; };
+
+            if (arg == "--filter")
+                options.filter = value();
+            else if (arg == "--json")
+                options.jsonPath = value();
+            else if (arg == "--min-time")
+                options.minTime = std::stod(value());
+            else if (arg == "--repetitions")
+                options.repetitions = std::max(1, std::stoi(value()));
+            else if (arg == "--cpu")
+                options.cpu = std::stoi(value());
+            else
+            {
+                std::cerr << std::format("Usage: {} [--filter substring] [--min-time seconds] [--repetitions n] "
+                                         "[--cpu n] [--json file]\n",
+                                         argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (options.cpu >= 0 && !pinToCpu(options.cpu))
+        {
+            std::cerr << std::format("Could not pin to CPU {}, running unpinned\n", options.cpu);
+            options.cpu = -1;
+        }
+
+        std::cout << std::format("{:<40}{:>14}{:>14}{:>16}{:>14}\n", "Benchmark", "Iterations", "ns/item", "items/s", "MB/s");
+        std::cout << std::string(98, '-') << "\n";
+
+        std::vector<Result> results;
+        for (const auto &benchmark : registry())
+        {
+            if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+                continue;
+
+            Result result = runOne(benchmark, options);
+            std::cout << std::format("{:<40}{:>14}{:>14.2f}{:>16.0f}{:>14}\n", result.name, result.iterations,
+                                     result.nsPerItem, result.itemsPerSecond,
+                                     result.bytesPerSecond > 0 ? std::format("{:.1f}", result.bytesPerSecond / 1e6) : "-");
+            results.push_back(result);
+        }
+
+        if (!options.jsonPath.empty())
+            writeJson(options.jsonPath, options, results);
+        return EXIT_SUCCESS;
+    }
+}
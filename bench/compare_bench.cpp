@@ -0,0 +1,242 @@
+#include "blitz_logger.hpp"
+#include "bench.hpp"
+#include "logger_access.hpp"
+
+#include <map>
+#include <optional>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// runs one workload through several sink modes, each in a fresh process, so the cost of a log
+// call can be split into enqueue, formatting and I/O
+namespace
+{
+    enum class Mode
+    {
+        ASYNC,
+        SYNC,
+        NULL_SINK,
+        NO_FORMAT
+    };
+
+    struct ModeInfo
+    {
+        Mode mode;
+        const char *name;
+        const char *description;
+    };
+
+    constexpr ModeInfo MODES[] = {
+        {Mode::ASYNC, "async", "ring buffers, the logger thread formats and writes the file"},
+        {Mode::SYNC, "sync", "Config::synchronous, the caller formats and writes the file under a lock"},
+        {Mode::NULL_SINK, "null", "the logger thread formats, output is discarded"},
+        {Mode::NO_FORMAT, "no_format", "the logger thread drains the buffers without formatting"}};
+
+    struct Options
+    {
+        std::vector<size_t> threadCounts{1, 4};
+        size_t messages{200'000}; // per thread
+        std::string filter;
+        std::string jsonPath;
+    };
+
+    struct Result
+    {
+        double callMeanNs;     // time spent in the log call
+        double callP99Ns;
+        double totalNs;        // first call until everything was written
+        double nsPerMessage;   // totalNs over all messages of all threads
+    };
+
+    Result runWorkload(Mode mode, const char *name, size_t threadCount, size_t messages)
+    {
+        Logger::Config cfg;
+        cfg.logDir = "bench_logs";
+        cfg.filePrefix = std::format("compare_{}", name);
+        cfg.consoleOutput = false;
+        cfg.fileOutput = mode != Mode::NO_FORMAT;
+        cfg.maxFileSize = SIZE_MAX;
+        cfg.maxFiles = 2;
+        cfg.preallocateFiles = false;
+        cfg.synchronous = mode == Mode::SYNC;
+        Logger::initialize(cfg);
+
+        Logger *logger = Logger::getInstance();
+        if (mode == Mode::NULL_SINK)
+        {
+            // everything up to the write(2) happens, the bytes go nowhere
+            logger->flush();
+            int devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+            ::dup2(devNull, LoggerBenchAccess::logFd(*logger));
+            ::close(devNull);
+        }
+
+        auto logOne = [&](size_t thread, size_t i)
+        {
+            const double price = 100.0 + static_cast<double>(i % 1000) / 8.0;
+            LOG_INFO("Order {} for account {} filled at {:.2f}", i, thread, price);
+        };
+
+        std::vector<blitz_histogram::Histogram> callNs(threadCount);
+        std::atomic<size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+                                 {
+                // warm up: buffer allocation and first touch stay out of the measurement
+                for (size_t i = 0; i < 1000; ++i)
+                    logOne(t, i);
+                ready++;
+                while (!go.load())
+                    std::this_thread::yield();
+
+                for (size_t i = 0; i < messages; ++i)
+                {
+                    auto begin = std::chrono::steady_clock::now();
+                    logOne(t, i);
+                    callNs[t].record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
+                } });
+        }
+
+        while (ready.load() < threadCount)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        logger->flush(std::chrono::seconds(60));
+
+        const auto start = std::chrono::steady_clock::now();
+        go = true;
+        for (auto &thread : threads)
+            thread.join();
+        logger->flush(std::chrono::seconds(300));
+        const double totalNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        blitz_histogram::Snapshot calls;
+        for (const auto &histogram : callNs)
+            calls.merge(histogram.snapshot());
+
+        Logger::destroyInstance();
+        return {calls.mean(), static_cast<double>(calls.percentile(0.99)), totalNs,
+                totalNs / static_cast<double>(threadCount * messages)};
+    }
+
+    // the logger is a process wide singleton, so every mode gets a process of its own
+    std::optional<Result> runIsolated(const ModeInfo &mode, size_t threadCount, size_t messages)
+    {
+        int fds[2];
+        if (::pipe(fds) != 0)
+            return std::nullopt;
+
+        std::cout.flush();
+        pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            ::close(fds[0]);
+            Result result = runWorkload(mode.mode, mode.name, threadCount, messages);
+            (void)::write(fds[1], &result, sizeof(result));
+            ::_exit(EXIT_SUCCESS);
+        }
+
+        ::close(fds[1]);
+        Result result{};
+        bool complete = pid > 0 && ::read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+        ::close(fds[0]);
+        if (pid > 0)
+            ::waitpid(pid, nullptr, 0);
+        return complete ? std::optional<Result>(result) : std::nullopt;
+    }
+
+    void writeJson(const std::string &path, const std::vector<std::tuple<std::string, size_t, Result>> &results)
+    {
+        std::ofstream out(path);
+        out << "{\n  \"runs\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto &[mode, threads, r] = results[i];
+            out << std::format("    {{\"mode\": \"{}\", \"threads\": {}, \"call_mean_ns\": {:.1f}, \"call_p99_ns\": {:.0f}, "
+                               "\"total_ns\": {:.0f}, \"ns_per_message\": {:.1f}}}{}\n",
+                               mode, threads, r.callMeanNs, r.callP99Ns, r.totalNs, r.nsPerMessage,
+                               i + 1 < results.size() ? "," : "");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string
+        { return i + 1 < argc ? argv[++i] : ""; };
+
+        if (arg == "--threads")
+        {
+            options.threadCounts.clear();
+            std::stringstream list(value());
+            for (std::string item; std::getline(list, item, ',');)
+                options.threadCounts.push_back(std::stoul(item));
+        }
+        else if (arg == "--messages")
+            options.messages = std::stoul(value());
+        else if (arg == "--filter")
+            options.filter = value();
+        else if (arg == "--json")
+            options.jsonPath = value();
+        else
+        {
+            std::cerr << std::format("Usage: {} [--threads 1,4] [--messages per-thread] [--filter mode] [--json file]\n",
+                                     argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (const auto &mode : MODES)
+        std::cout << std::format("{:<12}{}\n", mode.name, mode.description);
+
+    std::vector<std::tuple<std::string, size_t, Result>> results;
+    for (size_t threads : options.threadCounts)
+    {
+        std::cout << std::format("\n{} thread(s), {} messages each\n", threads, options.messages);
+        std::cout << std::format("{:<12}{:>16}{:>16}{:>16}{:>16}\n", "Mode", "Call mean (ns)", "Call P99 (ns)",
+                                 "Written ns/msg", "Written msg/s");
+        std::cout << std::string(76, '-') << "\n";
+
+        std::map<Mode, Result> byMode;
+        for (const auto &mode : MODES)
+        {
+            if (!options.filter.empty() && options.filter != mode.name)
+                continue;
+
+            auto result = runIsolated(mode, threads, options.messages);
+            if (!result)
+            {
+                std::cout << std::format("{:<12}failed\n", mode.name);
+                continue;
+            }
+            std::cout << std::format("{:<12}{:>16.1f}{:>16.0f}{:>16.1f}{:>16.0f}\n", mode.name, result->callMeanNs,
+                                     result->callP99Ns, result->nsPerMessage, 1e9 / result->nsPerMessage);
+            byMode[mode.mode] = *result;
+            results.emplace_back(mode.name, threads, *result);
+        }
+
+        // the modes differ by one stage each, their differences attribute the async cost
+        if (byMode.count(Mode::ASYNC) && byMode.count(Mode::NULL_SINK) && byMode.count(Mode::NO_FORMAT))
+        {
+            const double enqueue = byMode[Mode::NO_FORMAT].nsPerMessage;
+            const double format = byMode[Mode::NULL_SINK].nsPerMessage - enqueue;
+            const double io = byMode[Mode::ASYNC].nsPerMessage - byMode[Mode::NULL_SINK].nsPerMessage;
+            std::cout << std::format("Per written message: enqueue + drain {:.1f} ns, formatting {:.1f} ns, file I/O {:.1f} ns\n",
+                                     enqueue, format, io);
+        }
+    }
+
+    if (!options.jsonPath.empty())
+        writeJson(options.jsonPath, results);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "blitz_logger.hpp"
+
+#include <utility>
+
+// logger internals the benchmarks drive directly, befriended by Logger
+struct LoggerBenchAccess
+{
+    using Buffer = Logger::ThreadLocalBuffer;
+    using Message = Logger::LogMessage;
+    using Context = Logger::Context;
+    using Arena = Logger::BufferArena;
+
+    static void format(Logger &logger, const Message &msg, std::vector<char> &buffer)
+    {
+        logger.formatLogMessage(msg, buffer);
+    }
+
+    static void write(Logger &logger, const char *data, size_t size)
+    {
+        logger.writeToFd(data, size);
+    }
+
+    static int logFd(Logger &logger)
+    {
+        return logger.logFd;
+    }
+
+    static void rotate(Logger &logger)
+    {
+        logger.rotateLogFile(std::chrono::system_clock::now());
+    }
+
+    // rings of threads starting from now on come from this arena, null allocates them again;
+    // returns the arena in use before
+    static std::shared_ptr<Arena> setArena(Logger &logger, std::shared_ptr<Arena> arena)
+    {
+        return std::exchange(logger.bufferArena, std::move(arena));
+    }
+};
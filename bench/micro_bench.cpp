@@ -0,0 +1,341 @@
+#include "blitz_logger.hpp"
+#include "bench.hpp"
+#include "blitz_escape.hpp"
+#include "logger_access.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// isolated microbenchmarks of the hot path stages: ring buffer, formatting, argument encoding,
+// escaping, file writes, rotation and level checks
+namespace
+{
+    using blitz_bench::State;
+    using Access = LoggerBenchAccess;
+
+    Logger::RecordView sampleRecord(std::string_view fields = {})
+    {
+        return {Logger::Level::INFO,
+                std::chrono::system_clock::now(),
+                std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                "Network",
+                "/home/build/project/src/network/connection_pool.cpp",
+                218,
+                "Connection 42 to 10.0.0.17:5432 established after 3 retries",
+                fields};
+    }
+
+    void addRingBenchmarks()
+    {
+        // one push and one pop on the same thread, no contention
+        blitz_bench::add("ring/push_pop", [](State &state)
+                         {
+            auto buffer = std::make_unique<Access::Buffer>();
+            Access::Message msg("short message", Logger::Level::INFO, Access::Context());
+            while (state.keepRunning())
+            {
+                buffer->push(std::move(msg));
+                buffer->pop(msg);
+            }
+            blitz_bench::doNotOptimize(msg.message.size()); });
+
+        // producer and consumer on separate threads (and CPUs when pinned), items are messages
+        blitz_bench::add("ring/spsc_transfer", [](State &state)
+                         {
+            auto buffer = std::make_unique<Access::Buffer>();
+            const size_t count = state.iterations();
+
+            std::thread consumer([&]()
+                                 {
+                blitz_bench::pinToCpu(state.cpu() >= 0 ? state.cpu() + 1 : -1);
+                Access::Message msg;
+                for (size_t received = 0; received < count;)
+                {
+                    if (buffer->pop(msg))
+                        received++;
+                } });
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; ++i)
+                buffer->push(Access::Message("short message", Logger::Level::INFO, Access::Context()));
+            consumer.join();
+            state.setElapsed(std::chrono::steady_clock::now() - start); });
+
+        // the same with the consumer taking whatever is waiting at once, as the logger thread does
+        blitz_bench::add("ring/spsc_transfer_batch", [](State &state)
+                         {
+            auto buffer = std::make_unique<Access::Buffer>();
+            const size_t count = state.iterations();
+
+            std::thread consumer([&]()
+                                 {
+                blitz_bench::pinToCpu(state.cpu() >= 0 ? state.cpu() + 1 : -1);
+                std::vector<Access::Message> batch;
+                batch.reserve(4096);
+                for (size_t received = 0; received < count;)
+                {
+                    received += buffer->popBatch(batch, 4096);
+                    batch.clear();
+                } });
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; ++i)
+                buffer->push(Access::Message("short message", Logger::Level::INFO, Access::Context()));
+            consumer.join();
+            state.setElapsed(std::chrono::steady_clock::now() - start); });
+    }
+
+    void addFormatBenchmarks()
+    {
+        struct Variant
+        {
+            const char *name;
+            bool timestamp, threadId, source, module;
+            Logger::Layout layout;
+        };
+
+        // one field at a time on top of the bare level + message, then everything per layout
+        for (const Variant &variant : {Variant{"format/text_bare", false, false, false, false, Logger::Layout::TEXT},
+                                       Variant{"format/text_timestamp", true, false, false, false, Logger::Layout::TEXT},
+                                       Variant{"format/text_thread_id", false, true, false, false, Logger::Layout::TEXT},
+                                       Variant{"format/text_source", false, false, true, false, Logger::Layout::TEXT},
+                                       Variant{"format/text_module", false, false, false, true, Logger::Layout::TEXT},
+                                       Variant{"format/text_all", true, true, true, true, Logger::Layout::TEXT},
+                                       Variant{"format/json_all", true, true, true, true, Logger::Layout::JSON},
+                                       Variant{"format/logfmt_all", true, true, true, true, Logger::Layout::LOGFMT}})
+        {
+            blitz_bench::add(variant.name, [variant](State &state)
+                             {
+                Logger::Config cfg;
+                cfg.showTimestamp = variant.timestamp;
+                cfg.showThreadId = variant.threadId;
+                cfg.showSourceLocation = variant.source;
+                cfg.showModuleName = variant.module;
+                cfg.layout = variant.layout;
+
+                auto record = sampleRecord();
+                std::vector<char> buffer;
+                buffer.reserve(4096);
+                uint64_t bytes = 0;
+                while (state.keepRunning())
+                {
+                    buffer.clear();
+                    Logger::formatRecord(cfg, record, buffer);
+                    bytes += buffer.size();
+                }
+                state.setBytesProcessed(bytes); });
+        }
+
+        // structured fields rendered by the logger thread
+        blitz_bench::add("format/text_fields", [](State &state)
+                         {
+            Logger::Config cfg;
+            std::string fields;
+            blitz_binary::encodeArgs(fields, std::string_view("latency_us"), 1250, std::string_view("status"), 200,
+                                     std::string_view("path"), std::string_view("/api/items"));
+            auto record = sampleRecord(fields);
+            std::vector<char> buffer;
+            buffer.reserve(4096);
+            while (state.keepRunning())
+            {
+                buffer.clear();
+                Logger::formatRecord(cfg, record, buffer);
+            }
+            blitz_bench::doNotOptimize(buffer.data()); });
+
+        // full consumer side formatting of a queued message, text and binary encoded arguments
+        blitz_bench::add("format/message_text", [](State &state)
+                         {
+            Access::Message msg("Connection 42 to 10.0.0.17:5432 established after 3 retries",
+                                Logger::Level::INFO, Access::Context());
+            std::vector<char> buffer;
+            buffer.reserve(4096);
+            while (state.keepRunning())
+            {
+                buffer.clear();
+                Access::format(*Logger::getInstance(), msg, buffer);
+            }
+            blitz_bench::doNotOptimize(buffer.data()); });
+
+        blitz_bench::add("format/message_deferred", [](State &state)
+                         {
+            Access::Message msg({}, Logger::Level::INFO, Access::Context());
+            msg.format = "Connection {} to {} established after {} retries";
+            blitz_binary::encodeArgs(msg.message, 42, std::string_view("10.0.0.17:5432"), 3);
+            std::vector<char> buffer;
+            buffer.reserve(4096);
+            while (state.keepRunning())
+            {
+                buffer.clear();
+                Access::format(*Logger::getInstance(), msg, buffer);
+            }
+            blitz_bench::doNotOptimize(buffer.data()); });
+    }
+
+    void addEncodeBenchmarks()
+    {
+        // producer side cost of a text message against binary encoded arguments
+        blitz_bench::add("encode/std_format", [](State &state)
+                         {
+            int id = 42;
+            while (state.keepRunning())
+            {
+                std::string text = std::format("Connection {} to {} established after {} retries in {} ms",
+                                               id, "10.0.0.17:5432", 3, 12.5);
+                blitz_bench::doNotOptimize(text.data());
+            } });
+
+        blitz_bench::add("encode/deferred_args", [](State &state)
+                         {
+            int id = 42;
+            while (state.keepRunning())
+            {
+                std::string encoded;
+                blitz_binary::encodeArgs(encoded, id, "10.0.0.17:5432", 3, 12.5);
+                blitz_bench::doNotOptimize(encoded.data());
+            } });
+    }
+
+    void addEscapeBenchmarks()
+    {
+        // a 120-byte message without anything to escape, then 64KB of it, then one with escapes
+        struct Input
+        {
+            const char *name;
+            std::string text;
+        };
+        const std::string message(120, 'm');
+        const Input inputs[] = {{"escape/sanitize_clean_120", message},
+                                {"escape/sanitize_clean_64k", std::string(64 * 1024, 'm')},
+                                {"escape/sanitize_dirty_120", message.substr(0, 100) + "\nline\ttab\\path\x1b[0m"},
+                                {"escape/json_clean_120", message}};
+
+        for (const auto &input : inputs)
+        {
+            const bool json = std::string_view(input.name).starts_with("escape/json");
+            blitz_bench::add(input.name, [text = input.text, json](State &state)
+                             {
+                std::vector<char> buffer;
+                buffer.reserve(2 * text.size());
+                while (state.keepRunning())
+                {
+                    buffer.clear();
+                    if (json)
+                        blitz_escape::appendJsonEscaped(buffer, text);
+                    else
+                        blitz_escape::appendSanitized(buffer, text);
+                    blitz_bench::doNotOptimize(buffer.data());
+                }
+                state.setBytesProcessed(state.iterations() * text.size()); });
+        }
+    }
+
+    void addSinkBenchmarks()
+    {
+        // the active log file, truncated now and then so the benchmark does not fill the disk
+        for (size_t chunk : {size_t{4096}, size_t{256 * 1024}})
+        {
+            blitz_bench::add(std::format("sink/write_{}k", chunk / 1024), [chunk](State &state)
+                             {
+                Logger &logger = *Logger::getInstance();
+                std::vector<char> data(chunk, 'x');
+                size_t written = 0;
+                while (state.keepRunning())
+                {
+                    Access::write(logger, data.data(), data.size());
+                    written += chunk;
+                    if (written >= 256 * 1024 * 1024)
+                    {
+                        state.pauseTiming();
+                        (void)::ftruncate(Access::logFd(logger), 0);
+                        written = 0;
+                        state.resumeTiming();
+                    }
+                }
+                (void)::ftruncate(Access::logFd(logger), 0);
+                state.setBytesProcessed(state.iterations() * chunk); });
+        }
+
+        // descriptor swap on the logger thread's side, the maintenance thread renames in the background
+        blitz_bench::add("sink/rotate", [](State &state)
+                         {
+            Logger &logger = *Logger::getInstance();
+            while (state.keepRunning())
+                Access::rotate(logger); }, 5000);
+    }
+
+    void addStartupBenchmarks()
+    {
+        // first log call of a fresh thread: ring allocation, registration and the push, without the
+        // thread creation; the arena variant recycles rings of exited threads through a few slots,
+        // the plain one allocates every ring
+        for (bool arena : {false, true})
+        {
+            blitz_bench::add(arena ? "startup/first_log_arena" : "startup/first_log", [arena](State &state)
+                             {
+                Logger &logger = *Logger::getInstance();
+                auto previous = Access::setArena(logger, arena ? std::make_shared<Access::Arena>(8, Access::Buffer::roundCapacity(Logger::Config{}.bufferCapacity))
+                                                               : nullptr);
+
+                std::chrono::nanoseconds total{0};
+                for (size_t i = 0; i < state.iterations(); ++i)
+                {
+                    std::thread([&]()
+                                {
+                        auto start = std::chrono::steady_clock::now();
+                        LOG_INFO("First message of a thread");
+                        total += std::chrono::steady_clock::now() - start; })
+                        .join();
+                }
+                state.setElapsed(total);
+                Access::setArena(logger, std::move(previous)); }, 2000);
+        }
+    }
+
+    void addLevelBenchmarks()
+    {
+        blitz_bench::add("level/disabled_debug", [](State &state)
+                         {
+            int i = 0;
+            while (state.keepRunning())
+                LOG_DEBUG("Disabled message {}", i++); });
+
+        blitz_bench::add("level/disabled_debug_every_n", [](State &state)
+                         {
+            int i = 0;
+            while (state.keepRunning())
+                LOG_DEBUG_EVERY_N(100, "Disabled message {}", i++); });
+
+        // enabled call including the push, the logger thread drains concurrently
+        blitz_bench::add("level/enabled_info", [](State &state)
+                         {
+            int i = 0;
+            while (state.keepRunning())
+                LOG_INFO("Enabled message {}", i++);
+            Logger::getInstance()->flush(std::chrono::seconds(30)); });
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "bench_logs";
+    cfg.filePrefix = "micro_bench";
+    cfg.consoleOutput = false;
+    cfg.maxFileSize = SIZE_MAX; // the sink benchmarks rotate explicitly
+    cfg.maxFiles = 3;
+    cfg.preallocateFiles = false;
+    Logger::initialize(cfg);
+
+    addRingBenchmarks();
+    addFormatBenchmarks();
+    addEncodeBenchmarks();
+    addEscapeBenchmarks();
+    addSinkBenchmarks();
+    addStartupBenchmarks();
+    addLevelBenchmarks();
+
+    int rc = blitz_bench::runMain(argc, argv);
+    Logger::destroyInstance();
+    return rc;
+}
@@ -0,0 +1,234 @@
+#include "blitz_logger.hpp"
+#include "bench.hpp"
+
+#include <sstream>
+
+// open-loop load generator: every producer issues log calls on a fixed schedule, independent of
+// how long earlier calls took, and latency is measured from the intended start of each call, so a
+// stall shows up in every call it delays instead of just one (no coordinated omission)
+namespace
+{
+    struct Options
+    {
+        std::vector<size_t> threadCounts{1, 4};
+        std::vector<double> rates{25'000, 50'000, 100'000, 200'000, 400'000, 800'000, 1'600'000}; // per thread
+        double duration{2.0};
+        int cpu{-1};
+        bool endToEnd{false}; // enables Config::latencyHistograms, which adds a clock read per call
+        std::string jsonPath;
+    };
+
+    struct Step
+    {
+        size_t threads;
+        double offeredRate; // total calls/s
+        double achievedRate;
+        blitz_histogram::Snapshot response; // intended start to completion
+        blitz_histogram::Snapshot service;  // actual start to completion
+        blitz_histogram::Snapshot endToEnd; // log call until written by the logger thread
+        uint64_t blockedPushes;
+        uint64_t yieldSpins;
+    };
+
+    std::vector<double> parseList(const std::string &text)
+    {
+        std::vector<double> values;
+        std::stringstream stream(text);
+        for (std::string item; std::getline(stream, item, ',');)
+            values.push_back(std::stod(item));
+        return values;
+    }
+
+    // median cost of the two clock reads around each call, subtracted from the samples
+    uint64_t clockOverheadNs()
+    {
+        std::vector<int64_t> samples;
+        for (int i = 0; i < 10001; ++i)
+        {
+            auto a = std::chrono::steady_clock::now();
+            auto b = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return static_cast<uint64_t>(samples[samples.size() / 2]);
+    }
+
+    void waitUntil(std::chrono::steady_clock::time_point deadline)
+    {
+        for (auto now = std::chrono::steady_clock::now(); now < deadline; now = std::chrono::steady_clock::now())
+        {
+            if (deadline - now > std::chrono::microseconds(200))
+                std::this_thread::sleep_for(deadline - now - std::chrono::microseconds(100));
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    Step runStep(size_t threadCount, double perThreadRate, const Options &options, uint64_t overheadNs)
+    {
+        const auto interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / perThreadRate));
+        const size_t callsPerThread = static_cast<size_t>(perThreadRate * options.duration);
+        const std::string payload(64, 'x');
+
+        std::vector<blitz_histogram::Histogram> response(threadCount);
+        std::vector<blitz_histogram::Histogram> service(threadCount);
+        std::vector<std::thread> threads;
+
+        Logger *logger = Logger::getInstance();
+        Logger::Metrics before = logger->metrics();
+
+        const auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+        for (size_t t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+                                 {
+                if (options.cpu >= 0)
+                    blitz_bench::pinToCpu(options.cpu + 1 + static_cast<int>(t));
+
+                for (size_t i = 0; i < callsPerThread; ++i)
+                {
+                    const auto intended = start + interval * i;
+                    waitUntil(intended); // returns at once when behind schedule
+
+                    const auto begin = std::chrono::steady_clock::now();
+                    LOG_INFO("Open loop {} - {} - {}", t, payload, i);
+                    const auto end = std::chrono::steady_clock::now();
+
+                    auto ns = [&](auto from)
+                    {
+                        auto elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - from).count());
+                        return elapsed > overheadNs ? elapsed - overheadNs : 0;
+                    };
+                    response[t].record(ns(intended));
+                    service[t].record(ns(begin));
+                } });
+        }
+
+        for (auto &thread : threads)
+            thread.join();
+        const auto end = std::chrono::steady_clock::now();
+        logger->flush(std::chrono::seconds(60));
+        Logger::Metrics after = logger->metrics(); // retired rings stay in the totals
+
+        Step step{threadCount, perThreadRate * static_cast<double>(threadCount),
+                  static_cast<double>(callsPerThread * threadCount) / std::chrono::duration<double>(end - start).count(),
+                  {}, {}, after.endToEndNs.since(before.endToEndNs), after.blockedPushes - before.blockedPushes,
+                  after.yieldSpins - before.yieldSpins};
+        for (size_t t = 0; t < threadCount; ++t)
+        {
+            step.response.merge(response[t].snapshot());
+            step.service.merge(service[t].snapshot());
+        }
+        return step;
+    }
+
+    // saturated once the producers fall behind the schedule or the tail explodes
+    bool saturated(const Step &step, const Step &baseline)
+    {
+        return step.achievedRate < 0.95 * step.offeredRate ||
+               step.response.percentile(0.99) > 10 * std::max<uint64_t>(baseline.response.percentile(0.99), 1000);
+    }
+
+    void writeJson(const std::string &path, const std::vector<Step> &steps, uint64_t overheadNs)
+    {
+        std::ofstream out(path);
+        out << std::format("{{\n  \"clock_overhead_ns\": {},\n  \"steps\": [\n", overheadNs);
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            const auto &s = steps[i];
+            out << std::format("    {{\"threads\": {}, \"offered_rate\": {:.0f}, \"achieved_rate\": {:.0f}, "
+                               "\"blocked_pushes\": {}, \"yield_spins\": {}, \"response_ns\": {}, \"service_ns\": {}, "
+                               "\"end_to_end_ns\": {}}}{}\n",
+                               s.threads, s.offeredRate, s.achievedRate, s.blockedPushes, s.yieldSpins,
+                               s.response.toJson(), s.service.toJson(), s.endToEnd.toJson(), i + 1 < steps.size() ? "," : "");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string
+        { return i + 1 < argc ? argv[++i] : ""; };
+
+        if (arg == "--threads")
+        {
+            options.threadCounts.clear();
+            for (double count : parseList(value()))
+                options.threadCounts.push_back(static_cast<size_t>(count));
+        }
+        else if (arg == "--rates")
+            options.rates = parseList(value());
+        else if (arg == "--duration")
+            options.duration = std::stod(value());
+        else if (arg == "--end-to-end")
+            options.endToEnd = true;
+        else if (arg == "--cpu")
+            options.cpu = std::stoi(value());
+        else if (arg == "--json")
+            options.jsonPath = value();
+        else
+        {
+            std::cerr << std::format("Usage: {} [--threads 1,4] [--rates 25000,50000,...] [--duration seconds] "
+                                     "[--end-to-end] [--cpu first] [--json file]\n",
+                                     argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Logger::Config cfg;
+    cfg.logDir = "bench_logs";
+    cfg.filePrefix = "open_loop_bench";
+    cfg.consoleOutput = false;
+    cfg.maxFileSize = 256 * 1024 * 1024;
+    cfg.maxFiles = 2;
+    cfg.latencyHistograms = options.endToEnd;
+    if (options.cpu >= 0)
+        cfg.loggerThreadOptions.cpus = {options.cpu}; // the logger thread takes the CPU just before the producers
+    Logger::initialize(cfg);
+
+    const uint64_t overheadNs = clockOverheadNs();
+    std::cout << std::format("Clock overhead: {} ns, subtracted from every sample\n", overheadNs);
+
+    std::vector<Step> steps;
+    for (size_t threads : options.threadCounts)
+    {
+        std::cout << std::format("\n{} producer thread(s), response time measured from the intended start\n", threads);
+        std::cout << std::format("{:>12}{:>12}{:>11}{:>11}{:>11}{:>12}{:>14}{:>12}{:>12}\n", "Offered/s", "Achieved/s",
+                                 "P50 (μs)", "P99 (μs)", "P99.9 (μs)", "Max (μs)", "Svc P99 (μs)", "Blocked", "Yields");
+        std::cout << std::string(107, '-') << "\n";
+
+        // the lowest rate is the unloaded reference for the tail
+        const size_t baseline = steps.size();
+        for (double rate : options.rates)
+        {
+            Step step = runStep(threads, rate, options, overheadNs);
+            std::cout << std::format("{:>12.0f}{:>12.0f}{:>11.2f}{:>11.2f}{:>11.2f}{:>12.2f}{:>14.2f}{:>12}{:>12}\n",
+                                     step.offeredRate, step.achievedRate,
+                                     step.response.percentile(0.5) / 1000.0, step.response.percentile(0.99) / 1000.0,
+                                     step.response.percentile(0.999) / 1000.0, step.response.max / 1000.0,
+                                     step.service.percentile(0.99) / 1000.0, step.blockedPushes, step.yieldSpins);
+            if (options.endToEnd)
+                std::cout << std::format("{:>24}{:>11.2f}{:>11.2f}{:>11.2f}{:>12.2f}  end to end, call to write\n", "",
+                                         step.endToEnd.percentile(0.5) / 1000.0, step.endToEnd.percentile(0.99) / 1000.0,
+                                         step.endToEnd.percentile(0.999) / 1000.0, step.endToEnd.max / 1000.0);
+            steps.push_back(step);
+
+            if (saturated(step, steps[baseline]))
+            {
+                std::cout << std::format("Saturated at {:.0f} calls/s offered\n", step.offeredRate);
+                break;
+            }
+        }
+    }
+
+    if (!options.jsonPath.empty())
+        writeJson(options.jsonPath, steps, overheadNs);
+
+    Logger::destroyInstance();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+#include "blitz_binary.hpp"
+#include <format>
+#include <stdexcept>
+
+namespace blitz_binary
+{
+    namespace
+    {
+        struct PayloadCursor
+        {
+            std::string_view data;
+            size_t pos{0};
+
+            uint8_t byte()
+            {
+                if (pos >= data.size())
+                    throw std::runtime_error("Truncated argument payload");
+                return static_cast<uint8_t>(data[pos++]);
+            }
+
+            uint64_t varint()
+            {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    uint8_t b = byte();
+                    value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                    if (!(b & 0x80))
+                        return value;
+                }
+                throw std::runtime_error("Malformed varint in argument payload");
+            }
+
+            std::string_view bytes(size_t count)
+            {
+                if (count > data.size() - pos)
+                    throw std::runtime_error("Truncated argument payload");
+                auto result = data.substr(pos, count);
+                pos += count;
+                return result;
+            }
+        };
+
+        // render one argument with a std::format spec such as ":>10" or ""
+        void renderArg(std::string &out, const ArgValue &arg, std::string_view spec)
+        {
+            std::string field = std::format("{{{}}}", spec);
+            std::visit([&](const auto &value)
+                       { out += std::vformat(field, std::make_format_args(value)); },
+                       arg);
+        }
+
+        // integer value of a dynamic width/precision argument
+        std::string dynamicValue(const ArgValue &arg)
+        {
+            return std::visit([](const auto &value) -> std::string
+                              {
+                                  using T = std::decay_t<decltype(value)>;
+                                  if constexpr (std::same_as<T, int64_t> || std::same_as<T, uint64_t>)
+                                      return std::to_string(value);
+                                  else
+                                      throw std::format_error("dynamic width must be an integer"); },
+                              arg);
+        }
+    }
+
+    size_t decodeArg(std::string_view payload, size_t pos, ArgView &arg)
+    {
+        PayloadCursor cursor{payload, pos};
+
+        switch (static_cast<ArgType>(cursor.byte()))
+        {
+        case ArgType::BOOL:
+            arg = cursor.byte() != 0;
+            break;
+        case ArgType::CHAR:
+            arg = static_cast<char>(cursor.byte());
+            break;
+        case ArgType::INT:
+            arg = unzigzag(cursor.varint());
+            break;
+        case ArgType::UINT:
+            arg = cursor.varint();
+            break;
+        case ArgType::FLOAT:
+        {
+            float value;
+            std::memcpy(&value, cursor.bytes(sizeof(value)).data(), sizeof(value));
+            arg = value;
+            break;
+        }
+        case ArgType::DOUBLE:
+        {
+            double value;
+            std::memcpy(&value, cursor.bytes(sizeof(value)).data(), sizeof(value));
+            arg = value;
+            break;
+        }
+        case ArgType::STRING:
+            arg = cursor.bytes(cursor.varint());
+            break;
+        default:
+            throw std::runtime_error("Unknown argument type in payload");
+        }
+
+        return cursor.pos;
+    }
+
+    std::vector<ArgValue> decodeArgs(std::string_view payload)
+    {
+        std::vector<ArgValue> args;
+        forEachArg(payload, [&args](const ArgView &arg)
+                   { std::visit([&args](const auto &value)
+                                {
+                                    if constexpr (std::same_as<std::decay_t<decltype(value)>, std::string_view>)
+                                        args.emplace_back(std::string(value));
+                                    else
+                                        args.emplace_back(value); },
+                                arg); });
+        return args;
+    }
+
+    std::string render(std::string_view format, const std::vector<ArgValue> &args)
+    {
+        std::string out;
+        out.reserve(format.size() + args.size() * 8);
+        size_t nextArg = 0;
+
+        auto argAt = [&](std::string_view id) -> const ArgValue &
+        {
+            size_t index = id.empty() ? nextArg++ : std::stoul(std::string(id));
+            if (index >= args.size())
+                throw std::format_error("argument index out of range");
+            return args[index];
+        };
+
+        for (size_t i = 0; i < format.size(); ++i)
+        {
+            char c = format[i];
+            if (c == '}')
+            {
+                out += '}';
+                if (i + 1 < format.size() && format[i + 1] == '}')
+                    ++i;
+                continue;
+            }
+            if (c != '{')
+            {
+                out += c;
+                continue;
+            }
+            if (i + 1 < format.size() && format[i + 1] == '{')
+            {
+                out += '{';
+                ++i;
+                continue;
+            }
+
+            // find the end of the replacement field, allowing nested {} for dynamic width/precision
+            size_t end = i + 1;
+            for (int depth = 1; end < format.size(); ++end)
+            {
+                if (format[end] == '{')
+                    ++depth;
+                else if (format[end] == '}' && --depth == 0)
+                    break;
+            }
+            std::string_view field = format.substr(i + 1, end - i - 1);
+            i = end;
+
+            try
+            {
+                auto colon = field.find(':');
+                const ArgValue &arg = argAt(field.substr(0, colon));
+
+                std::string spec;
+                if (colon != std::string_view::npos)
+                {
+                    // substitute nested dynamic arguments with their values
+                    std::string_view rest = field.substr(colon);
+                    for (size_t j = 0; j < rest.size(); ++j)
+                    {
+                        if (rest[j] != '{')
+                        {
+                            spec += rest[j];
+                            continue;
+                        }
+                        size_t close = rest.find('}', j);
+                        spec += dynamicValue(argAt(rest.substr(j + 1, close - j - 1)));
+                        j = close;
+                    }
+                }
+
+                renderArg(out, arg, spec);
+            }
+            catch (const std::exception &)
+            {
+                // keep the raw field so a bad spec does not lose the rest of the message
+                out += '{';
+                out += field;
+                out += '}';
+            }
+        }
+
+        return out;
+    }
+
+    uint8_t Reader::readByte()
+    {
+        int c = in.get();
+        if (c == std::char_traits<char>::eof())
+            throw std::runtime_error("Unexpected end of binary log");
+        return static_cast<uint8_t>(c);
+    }
+
+    uint64_t Reader::readVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t b = readByte();
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return value;
+        }
+        throw std::runtime_error("Malformed varint in binary log");
+    }
+
+    std::string Reader::readString()
+    {
+        std::string str(readVarint(), '\0');
+        if (!in.read(str.data(), static_cast<std::streamsize>(str.size())))
+            throw std::runtime_error("Unexpected end of binary log");
+        return str;
+    }
+
+    void Reader::readHeader()
+    {
+        // the first magic byte has already been consumed
+        char rest[MAGIC.size() - 1];
+        if (!in.read(rest, sizeof(rest)) || std::memcmp(rest, MAGIC.data() + 1, sizeof(rest)) != 0)
+            throw std::runtime_error("Not a blitz binary log");
+
+        version = readByte();
+        if (version < MIN_VERSION || version > VERSION)
+            throw std::runtime_error(std::format("Unsupported binary log version: {}", version));
+
+        lastTimestampNs = static_cast<int64_t>(readVarint());
+        callSites.clear();
+        modules.clear();
+        threads.clear();
+        headerSeen = true;
+    }
+
+    bool Reader::next(DecodedMessage &msg)
+    {
+        while (true)
+        {
+            int c = in.get();
+            if (c == std::char_traits<char>::eof())
+                return false;
+
+            if (c == MAGIC[0])
+            {
+                readHeader();
+                continue;
+            }
+            if (!headerSeen)
+                throw std::runtime_error("Not a blitz binary log");
+
+            switch (static_cast<Tag>(c))
+            {
+            case Tag::CALL_SITE:
+            {
+                uint64_t id = readVarint();
+                CallSite site;
+                site.level = readByte();
+                site.line = static_cast<int>(readVarint());
+                site.file = readString();
+                site.function = readString();
+                site.format = readString();
+                callSites[id] = std::move(site);
+                break;
+            }
+            case Tag::MODULE:
+            {
+                uint64_t id = readVarint();
+                modules[id] = readString();
+                break;
+            }
+            case Tag::THREAD:
+            {
+                uint64_t id = readVarint();
+                threads[id] = readVarint();
+                break;
+            }
+            case Tag::MESSAGE:
+            {
+                auto site = callSites.find(readVarint());
+                auto module = modules.find(readVarint());
+                auto thread = threads.find(readVarint());
+                if (site == callSites.end() || module == modules.end() || thread == threads.end())
+                    throw std::runtime_error("Message references an undefined dictionary entry");
+
+                lastTimestampNs += unzigzag(readVarint());
+                std::string payload = readString();
+                msg.fields = version >= 2 ? readString() : std::string();
+
+                msg.level = site->second.level;
+                msg.timestampNs = lastTimestampNs;
+                msg.threadHash = thread->second;
+                msg.line = site->second.line;
+                msg.module = module->second;
+                msg.file = site->second.file;
+                msg.function = site->second.function;
+                msg.message = render(site->second.format, decodeArgs(payload));
+                return true;
+            }
+            default:
+                throw std::runtime_error(std::format("Unknown record tag: {}", c));
+            }
+        }
+    }
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// compact binary log format shared by the logger and the blitz_decode tool
+//
+// file    := header record*
+// header  := "BLZB" u8:version varint:baseTimestampNs   (may repeat, resets all dictionaries)
+// record  := u8:tag body
+//   CALL_SITE : varint:id u8:level varint:line str:file str:function str:format
+//   MODULE    : varint:id str:name
+//   THREAD    : varint:id varint:threadHash
+//   MESSAGE   : varint:callSiteId varint:moduleId varint:threadId varint:zigzag(timestampDeltaNs) str:args str:fields
+//               (version 1 has no fields)
+// str     := varint:length bytes
+// args    := (u8:type value)*
+// fields  := (STRING:key value)*   (structured key-value fields, see LOG_*_KV)
+namespace blitz_binary
+{
+    inline constexpr std::array<char, 4> MAGIC = {'B', 'L', 'Z', 'B'};
+    inline constexpr uint8_t VERSION = 2;
+    inline constexpr uint8_t MIN_VERSION = 1; // oldest version the reader still decodes
+
+    // format used for messages that were rendered to text before reaching the encoder
+    inline constexpr std::string_view PREFORMATTED = "{}";
+
+    enum class Tag : uint8_t
+    {
+        CALL_SITE = 1,
+        MODULE = 2,
+        THREAD = 3,
+        MESSAGE = 4
+    };
+
+    enum class ArgType : uint8_t
+    {
+        BOOL = 1,
+        CHAR = 2,
+        INT = 3,    // zigzag varint
+        UINT = 4,   // varint
+        FLOAT = 5,  // 4 bytes
+        DOUBLE = 6, // 8 bytes
+        STRING = 7  // varint length + bytes
+    };
+
+    template <typename Buffer>
+    inline void putVarint(Buffer &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    template <typename Buffer>
+    inline void putString(Buffer &out, std::string_view str)
+    {
+        putVarint(out, str.size());
+        out.insert(out.end(), str.begin(), str.end());
+    }
+
+    inline constexpr uint64_t zigzag(int64_t value) noexcept
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline constexpr int64_t unzigzag(uint64_t value) noexcept
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    // types whose std::format output can be reproduced from the encoded value
+    template <typename T>
+    concept Encodable =
+        std::same_as<std::remove_cvref_t<T>, bool> ||
+        std::same_as<std::remove_cvref_t<T>, char> ||
+        (std::integral<std::remove_cvref_t<T>> && sizeof(std::remove_cvref_t<T>) <= 8) ||
+        std::same_as<std::remove_cvref_t<T>, float> ||
+        std::same_as<std::remove_cvref_t<T>, double> ||
+        std::convertible_to<const T &, std::string_view>;
+
+    template <typename... Args>
+    inline constexpr bool AllEncodable = (Encodable<Args> && ...);
+
+    template <typename Buffer, typename T>
+    inline void encodeArg(Buffer &out, const T &arg)
+    {
+        using U = std::remove_cvref_t<T>;
+
+        if constexpr (std::same_as<U, bool>)
+        {
+            out.push_back(static_cast<char>(ArgType::BOOL));
+            out.push_back(static_cast<char>(arg));
+        }
+        else if constexpr (std::same_as<U, char>)
+        {
+            out.push_back(static_cast<char>(ArgType::CHAR));
+            out.push_back(arg);
+        }
+        else if constexpr (std::integral<U> && std::is_signed_v<U>)
+        {
+            out.push_back(static_cast<char>(ArgType::INT));
+            putVarint(out, zigzag(static_cast<int64_t>(arg)));
+        }
+        else if constexpr (std::integral<U>)
+        {
+            out.push_back(static_cast<char>(ArgType::UINT));
+            putVarint(out, static_cast<uint64_t>(arg));
+        }
+        else if constexpr (std::same_as<U, float> || std::same_as<U, double>)
+        {
+            out.push_back(static_cast<char>(std::same_as<U, float> ? ArgType::FLOAT : ArgType::DOUBLE));
+            char bytes[sizeof(U)];
+            std::memcpy(bytes, &arg, sizeof(U));
+            out.insert(out.end(), bytes, bytes + sizeof(U));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(ArgType::STRING));
+            putString(out, std::string_view(arg));
+        }
+    }
+
+    template <typename Buffer, typename... Args>
+    inline void encodeArgs(Buffer &out, const Args &...args)
+    {
+        (encodeArg(out, args), ...);
+    }
+
+    using ArgValue = std::variant<bool, char, int64_t, uint64_t, float, double, std::string>;
+    using ArgView = std::variant<bool, char, int64_t, uint64_t, float, double, std::string_view>;
+
+    // decode the argument starting at pos, returns the position of the next one,
+    // throws std::runtime_error on corrupt input
+    size_t decodeArg(std::string_view payload, size_t pos, ArgView &arg);
+
+    // call visit(const ArgView &) for every argument of a payload without allocating
+    template <typename Visitor>
+    inline void forEachArg(std::string_view payload, Visitor &&visit)
+    {
+        ArgView arg;
+        for (size_t pos = 0; pos < payload.size();)
+        {
+            pos = decodeArg(payload, pos, arg);
+            visit(arg);
+        }
+    }
+
+    // decode an argument payload produced by encodeArgs, throws std::runtime_error on corrupt input
+    std::vector<ArgValue> decodeArgs(std::string_view payload);
+
+    // render a std::format string against decoded arguments
+    std::string render(std::string_view format, const std::vector<ArgValue> &args);
+
+    // render a message payload, text payloads (empty format) are returned unchanged
+    inline std::string renderPayload(std::string_view format, std::string_view payload)
+    {
+        if (format.empty())
+            return std::string(payload);
+        return render(format, decodeArgs(payload));
+    }
+
+    struct DecodedMessage
+    {
+        uint8_t level{0};
+        int64_t timestampNs{0}; // nanoseconds since epoch
+        uint64_t threadHash{0};
+        int line{0};
+        std::string module;
+        std::string file;
+        std::string function;
+        std::string message;
+        std::string fields; // encoded key-value fields
+    };
+
+    // sequential reader for binary log files
+    class Reader
+    {
+    public:
+        explicit Reader(std::istream &input) : in(input) {}
+
+        // read the next message, returns false at end of input, throws std::runtime_error on corrupt input
+        bool next(DecodedMessage &msg);
+
+    private:
+        struct CallSite
+        {
+            uint8_t level;
+            int line;
+            std::string file;
+            std::string function;
+            std::string format;
+        };
+
+        void readHeader();
+        uint64_t readVarint();
+        std::string readString();
+        uint8_t readByte();
+
+        std::istream &in;
+        bool headerSeen{false};
+        uint8_t version{VERSION};
+        int64_t lastTimestampNs{0};
+        std::unordered_map<uint64_t, CallSite> callSites;
+        std::unordered_map<uint64_t, std::string> modules;
+        std::unordered_map<uint64_t, uint64_t> threads;
+    };
+}
@@ -0,0 +1,397 @@
+#include "blitz_compress.hpp"
+#include "blitz_binary.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef BLITZ_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace blitz_compress
+{
+    namespace
+    {
+        // frame := "BLZ4" varint:rawSize varint:blockSize block
+        // block := sequence*, sequence := token literalLength+ literals [u16:offset matchLength+]
+        // (LZ4 block layout: the last sequence carries literals only)
+        constexpr std::array<char, 4> LZ_MAGIC = {'B', 'L', 'Z', '4'};
+        constexpr size_t MIN_MATCH = 4;
+        constexpr size_t LAST_LITERALS = 5; // trailing bytes always emitted as literals
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr int HASH_BITS = 14;
+
+        uint32_t read32(const char *p) noexcept
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash32(uint32_t value) noexcept
+        {
+            return (value * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        void putLength(std::vector<char> &out, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                out.push_back(static_cast<char>(255));
+            out.push_back(static_cast<char>(length));
+        }
+
+        void putSequence(std::vector<char> &out, const char *literals, size_t literalLength,
+                         size_t offset, size_t matchLength)
+        {
+            const size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+            out.push_back(static_cast<char>((std::min<size_t>(literalLength, 15) << 4) |
+                                            std::min<size_t>(matchCode, 15)));
+            if (literalLength >= 15)
+                putLength(out, literalLength - 15);
+            out.insert(out.end(), literals, literals + literalLength);
+
+            if (matchLength == 0)
+                return; // last sequence
+
+            out.push_back(static_cast<char>(offset & 0xff));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15)
+                putLength(out, matchCode - 15);
+        }
+
+        void compressBlock(std::string_view input, std::vector<char> &out)
+        {
+            const char *base = input.data();
+            const size_t size = input.size();
+            size_t anchor = 0;
+
+            if (size > MIN_MATCH + LAST_LITERALS)
+            {
+                // positions + 1 so that zero means empty, reused per thread to avoid a 64KB allocation per frame
+                static thread_local std::array<uint32_t, 1 << HASH_BITS> table;
+                table.fill(0);
+
+                const size_t matchLimit = size - LAST_LITERALS;
+                size_t pos = 0;
+
+                while (pos + MIN_MATCH <= matchLimit)
+                {
+                    const uint32_t sequence = read32(base + pos);
+                    uint32_t &slot = table[hash32(sequence)];
+                    const size_t candidate = slot;
+                    slot = static_cast<uint32_t>(pos + 1);
+
+                    if (candidate == 0 || pos + 1 - candidate > MAX_OFFSET || read32(base + candidate - 1) != sequence)
+                    {
+                        // skip faster through incompressible data
+                        pos += 1 + ((pos - anchor) >> 6);
+                        continue;
+                    }
+
+                    const size_t matchStart = candidate - 1;
+                    size_t length = MIN_MATCH;
+                    while (pos + length < matchLimit && base[matchStart + length] == base[pos + length])
+                        ++length;
+
+                    putSequence(out, base + anchor, pos - anchor, pos - matchStart, length);
+                    pos += length;
+                    anchor = pos;
+                }
+            }
+
+            putSequence(out, base + anchor, size - anchor, 0, 0);
+        }
+
+        size_t readLength(std::string_view block, size_t &pos)
+        {
+            size_t length = 0;
+            uint8_t b;
+            do
+            {
+                if (pos >= block.size())
+                    throw std::runtime_error("Truncated compressed block");
+                b = static_cast<uint8_t>(block[pos++]);
+                length += b;
+            } while (b == 255);
+            return length;
+        }
+
+        void decompressBlock(std::string_view block, size_t rawSize, std::vector<char> &out)
+        {
+            const size_t start = out.size();
+            out.resize(start + rawSize);
+            char *dst = out.data() + start;
+            size_t written = 0;
+            size_t pos = 0;
+
+            while (pos < block.size())
+            {
+                const uint8_t token = static_cast<uint8_t>(block[pos++]);
+
+                size_t literalLength = token >> 4;
+                if (literalLength == 15)
+                    literalLength += readLength(block, pos);
+                if (literalLength > block.size() - pos || literalLength > rawSize - written)
+                    throw std::runtime_error("Corrupt compressed block");
+                std::memcpy(dst + written, block.data() + pos, literalLength);
+                written += literalLength;
+                pos += literalLength;
+
+                if (pos == block.size())
+                    break; // last sequence
+
+                if (block.size() - pos < 2)
+                    throw std::runtime_error("Truncated compressed block");
+                const size_t offset = static_cast<uint8_t>(block[pos]) | (static_cast<size_t>(static_cast<uint8_t>(block[pos + 1])) << 8);
+                pos += 2;
+
+                size_t matchLength = token & 0xf;
+                if (matchLength == 15)
+                    matchLength += readLength(block, pos);
+                matchLength += MIN_MATCH;
+
+                if (offset == 0 || offset > written || matchLength > rawSize - written)
+                    throw std::runtime_error("Corrupt compressed block");
+
+                // overlapping matches repeat the bytes they produce, so those go byte by byte
+                const char *from = dst + written - offset;
+                if (offset >= matchLength)
+                    std::memcpy(dst + written, from, matchLength);
+                else
+                    for (size_t i = 0; i < matchLength; ++i)
+                        dst[written + i] = from[i];
+                written += matchLength;
+            }
+
+            if (written != rawSize)
+            {
+                out.resize(start);
+                throw std::runtime_error("Compressed block size mismatch");
+            }
+        }
+
+        uint64_t readVarint(std::string_view data, size_t &pos)
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                if (pos >= data.size())
+                    throw std::runtime_error("Truncated compressed frame");
+                uint8_t b = static_cast<uint8_t>(data[pos++]);
+                value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return value;
+            }
+            throw std::runtime_error("Malformed compressed frame header");
+        }
+
+        class LzCodec final : public Codec
+        {
+        public:
+            std::string_view name() const override { return "lz"; }
+            std::string_view extension() const override { return ".lz"; }
+
+            void compressFrame(std::string_view input, std::vector<char> &out) const override
+            {
+                static thread_local std::vector<char> block;
+                block.clear();
+                compressBlock(input, block);
+
+                out.insert(out.end(), LZ_MAGIC.begin(), LZ_MAGIC.end());
+                blitz_binary::putVarint(out, input.size());
+                blitz_binary::putVarint(out, block.size());
+                out.insert(out.end(), block.begin(), block.end());
+            }
+
+            void decompress(std::string_view input, std::vector<char> &out) const override
+            {
+                size_t pos = 0;
+                while (pos < input.size())
+                {
+                    if (!matches(input.substr(pos)))
+                        throw std::runtime_error("Bad compressed frame magic");
+                    pos += LZ_MAGIC.size();
+
+                    const uint64_t rawSize = readVarint(input, pos);
+                    const uint64_t blockSize = readVarint(input, pos);
+                    if (blockSize > input.size() - pos)
+                        throw std::runtime_error("Truncated compressed frame");
+                    if (rawSize > blockSize * 255 + 16) // beyond the best possible ratio
+                        throw std::runtime_error("Corrupt compressed frame header");
+
+                    decompressBlock(input.substr(pos, blockSize), rawSize, out);
+                    pos += blockSize;
+                }
+            }
+
+            bool matches(std::string_view data) const override
+            {
+                return data.size() >= LZ_MAGIC.size() && std::memcmp(data.data(), LZ_MAGIC.data(), LZ_MAGIC.size()) == 0;
+            }
+        };
+
+#ifdef BLITZ_WITH_ZLIB
+        class GzipCodec final : public Codec
+        {
+        public:
+            explicit GzipCodec(int lvl) : level(lvl) {}
+
+            std::string_view name() const override { return "gzip"; }
+            std::string_view extension() const override { return ".gz"; }
+
+            // each frame is a complete gzip member, concatenated members are valid gzip
+            void compressFrame(std::string_view input, std::vector<char> &out) const override
+            {
+                z_stream stream{};
+                if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                    throw std::runtime_error("deflateInit2 failed");
+
+                const size_t start = out.size();
+                out.resize(start + deflateBound(&stream, static_cast<uLong>(input.size())));
+
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+                stream.avail_in = static_cast<uInt>(input.size());
+                stream.next_out = reinterpret_cast<Bytef *>(out.data() + start);
+                stream.avail_out = static_cast<uInt>(out.size() - start);
+
+                int result = deflate(&stream, Z_FINISH);
+                out.resize(start + stream.total_out);
+                deflateEnd(&stream);
+
+                if (result != Z_STREAM_END)
+                    throw std::runtime_error("deflate failed");
+            }
+
+            void decompress(std::string_view input, std::vector<char> &out) const override
+            {
+                z_stream stream{};
+                if (inflateInit2(&stream, 15 + 32) != Z_OK)
+                    throw std::runtime_error("inflateInit2 failed");
+
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+                stream.avail_in = static_cast<uInt>(input.size());
+
+                char chunk[64 * 1024];
+                while (true)
+                {
+                    stream.next_out = reinterpret_cast<Bytef *>(chunk);
+                    stream.avail_out = sizeof(chunk);
+
+                    int result = inflate(&stream, Z_NO_FLUSH);
+                    out.insert(out.end(), chunk, chunk + (sizeof(chunk) - stream.avail_out));
+
+                    if (result == Z_STREAM_END)
+                    {
+                        if (stream.avail_in == 0)
+                            break;
+                        inflateReset(&stream); // next member
+                    }
+                    else if (result != Z_OK)
+                    {
+                        inflateEnd(&stream);
+                        throw std::runtime_error("Corrupt gzip data");
+                    }
+                    else if (stream.avail_in == 0 && stream.avail_out != 0)
+                    {
+                        inflateEnd(&stream);
+                        throw std::runtime_error("Truncated gzip data");
+                    }
+                }
+                inflateEnd(&stream);
+            }
+
+            bool matches(std::string_view data) const override
+            {
+                return data.size() >= 2 && static_cast<uint8_t>(data[0]) == 0x1f && static_cast<uint8_t>(data[1]) == 0x8b;
+            }
+
+        private:
+            int level;
+        };
+#endif
+    }
+
+    std::shared_ptr<const Codec> makeLzCodec()
+    {
+        return std::make_shared<LzCodec>();
+    }
+
+#ifdef BLITZ_WITH_ZLIB
+    std::shared_ptr<const Codec> makeGzipCodec(int level)
+    {
+        return std::make_shared<GzipCodec>(level);
+    }
+#endif
+
+    std::string compressFile(const Codec &codec, const std::string &path, size_t frameSize)
+    {
+        const std::string target = path + std::string(codec.extension());
+        const std::string partial = target + ".tmp";
+
+        std::ifstream input(path, std::ios::binary);
+        if (!input)
+            throw std::runtime_error(std::format("Failed to open {} for compression", path));
+        const auto modified = std::filesystem::last_write_time(path);
+
+        std::ofstream output(partial, std::ios::binary | std::ios::trunc);
+        if (!output)
+            throw std::runtime_error(std::format("Failed to create {}", partial));
+
+        std::vector<char> raw(frameSize);
+        std::vector<char> frame;
+        while (input)
+        {
+            input.read(raw.data(), static_cast<std::streamsize>(raw.size()));
+            const auto count = static_cast<size_t>(input.gcount());
+            if (count == 0)
+                break;
+
+            frame.clear();
+            codec.compressFrame(std::string_view(raw.data(), count), frame);
+            output.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        }
+
+        output.close();
+        if (!output || input.bad())
+        {
+            std::filesystem::remove(partial);
+            throw std::runtime_error(std::format("Failed to compress {}", path));
+        }
+
+        // keep the original modification time so the file still sorts by age,
+        // then publish the compressed file atomically and drop the original
+        std::filesystem::last_write_time(partial, modified);
+        std::filesystem::rename(partial, target);
+        if (!std::filesystem::remove(path))
+        {
+            // the original was deleted (e.g. by retention) while we compressed it, so is the copy
+            std::filesystem::remove(target);
+        }
+        return target;
+    }
+
+    std::vector<char> decompressAny(std::string_view data)
+    {
+        std::vector<std::shared_ptr<const Codec>> codecs = {makeLzCodec()};
+#ifdef BLITZ_WITH_ZLIB
+        codecs.push_back(makeGzipCodec());
+#endif
+
+        std::vector<char> out;
+        for (const auto &codec : codecs)
+        {
+            if (codec->matches(data))
+            {
+                codec->decompress(data, out);
+                return out;
+            }
+        }
+
+        out.assign(data.begin(), data.end());
+        return out;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// compression codecs for rotated and live log files
+//
+// every codec writes self-contained frames, so a compressed file is a plain concatenation
+// of frames and can be appended to or truncated at a frame boundary without losing the rest
+namespace blitz_compress
+{
+    class Codec
+    {
+    public:
+        virtual ~Codec() = default;
+
+        // short codec name, e.g. "lz" or "gzip"
+        virtual std::string_view name() const = 0;
+
+        // extension appended to compressed files, e.g. ".lz"
+        virtual std::string_view extension() const = 0;
+
+        // compress input into one frame appended to out, must be safe to call from several threads
+        virtual void compressFrame(std::string_view input, std::vector<char> &out) const = 0;
+
+        // decompress a concatenation of frames, throws std::runtime_error on corrupt input
+        virtual void decompress(std::string_view input, std::vector<char> &out) const = 0;
+
+        // true if data starts with a frame of this codec
+        virtual bool matches(std::string_view data) const = 0;
+    };
+
+    // built-in LZ4-style block compressor, no external dependencies
+    std::shared_ptr<const Codec> makeLzCodec();
+
+#ifdef BLITZ_WITH_ZLIB
+    // gzip members readable by zcat/gunzip, level 1 (fastest) to 9 (smallest)
+    std::shared_ptr<const Codec> makeGzipCodec(int level = 6);
+#endif
+
+    // compress path into path + codec.extension() in frames of frameSize bytes, then remove path,
+    // returns the compressed path, throws std::runtime_error (leaving path untouched) on failure,
+    // the compressed file is discarded if path is deleted by someone else in the meantime
+    std::string compressFile(const Codec &codec, const std::string &path, size_t frameSize = 1024 * 1024);
+
+    // decompress data with whichever built-in codec matches it, data matching none is returned as is
+    std::vector<char> decompressAny(std::string_view data);
+}
@@ -0,0 +1,255 @@
+#include "blitz_escape.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define BLITZ_ESCAPE_X86 1
+#endif
+
+namespace blitz_escape
+{
+    namespace
+    {
+        constexpr uint64_t ONES = 0x0101010101010101ULL;
+        constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+
+        // JSON: '"', '\\' and control characters, SANITIZE: '\\', control characters and DEL
+        enum class Scan
+        {
+            JSON,
+            SANITIZE
+        };
+
+        template <Scan S>
+        constexpr bool matches(unsigned char c) noexcept
+        {
+            if constexpr (S == Scan::JSON)
+                return c < 0x20 || c == '"' || c == '\\';
+            else
+                return c < 0x20 || c == 0x7f || c == '\\';
+        }
+
+        // nonzero if any byte of word is zero (exact for the lowest such byte)
+        constexpr uint64_t hasZeroByte(uint64_t word) noexcept
+        {
+            return (word - ONES) & ~word & HIGHS;
+        }
+
+        // nonzero if any byte of word is below n (n <= 128)
+        constexpr uint64_t hasByteBelow(uint64_t word, uint64_t n) noexcept
+        {
+            return (word - ONES * n) & ~word & HIGHS;
+        }
+
+        // portable fallback, 8 bytes per step
+        template <Scan S>
+        size_t scanSwar(const char *data, size_t size, size_t i) noexcept
+        {
+            const uint64_t second = S == Scan::JSON ? ONES * '"' : ONES * 0x7f;
+            const uint64_t third = ONES * '\\';
+
+            for (; i + 8 <= size; i += 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, data + i, sizeof(word));
+
+                if (hasByteBelow(word, 0x20) | hasZeroByte(word ^ second) | hasZeroByte(word ^ third))
+                    break;
+            }
+
+            for (; i < size; ++i)
+            {
+                if (matches<S>(static_cast<unsigned char>(data[i])))
+                    return i;
+            }
+            return std::string_view::npos;
+        }
+
+#ifdef BLITZ_ESCAPE_X86
+        // SSE2 is part of x86-64, so this path needs no runtime check
+        template <Scan S>
+        size_t scanSse2(const char *data, size_t size, size_t i) noexcept
+        {
+            const __m128i controlMax = _mm_set1_epi8(0x1f);
+            const __m128i second = _mm_set1_epi8(S == Scan::JSON ? '"' : 0x7f);
+            const __m128i third = _mm_set1_epi8('\\');
+
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+                // unsigned c <= 0x1f  <=>  max(c, 0x1f) == 0x1f
+                __m128i hits = _mm_cmpeq_epi8(_mm_max_epu8(chunk, controlMax), controlMax);
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, second));
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, third));
+
+                if (int mask = _mm_movemask_epi8(hits))
+                    return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+            }
+
+            return scanSwar<S>(data, size, i);
+        }
+
+        template <Scan S>
+        __attribute__((target("avx2"))) size_t scanAvx2(const char *data, size_t size, size_t i) noexcept
+        {
+            const __m256i controlMax = _mm256_set1_epi8(0x1f);
+            const __m256i second = _mm256_set1_epi8(S == Scan::JSON ? '"' : 0x7f);
+            const __m256i third = _mm256_set1_epi8('\\');
+
+            for (; i + 32 <= size; i += 32)
+            {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+
+                __m256i hits = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, controlMax), controlMax);
+                hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, second));
+                hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, third));
+
+                if (int mask = _mm256_movemask_epi8(hits))
+                    return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+            }
+
+            // clear the upper halves before running legacy SSE code on the tail,
+            // otherwise every call pays an AVX/SSE transition penalty
+            _mm256_zeroupper();
+            return scanSse2<S>(data, size, i);
+        }
+
+        // resolved once at startup so the hot path only tests a plain bool
+        const bool HAS_AVX2 = []
+        {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+#endif
+
+        template <Scan S>
+        size_t scan(std::string_view str, size_t from) noexcept
+        {
+            if (from >= str.size())
+                return std::string_view::npos;
+
+#ifdef BLITZ_ESCAPE_X86
+            if (HAS_AVX2)
+                return scanAvx2<S>(str.data(), str.size(), from);
+            return scanSse2<S>(str.data(), str.size(), from);
+#else
+            return scanSwar<S>(str.data(), str.size(), from);
+#endif
+        }
+
+        constexpr char HEX[] = "0123456789abcdef";
+
+        void appendJsonEscape(std::vector<char> &out, unsigned char c)
+        {
+            out.push_back('\\');
+            switch (c)
+            {
+            case '"':
+                out.push_back('"');
+                break;
+            case '\\':
+                out.push_back('\\');
+                break;
+            case '\n':
+                out.push_back('n');
+                break;
+            case '\r':
+                out.push_back('r');
+                break;
+            case '\t':
+                out.push_back('t');
+                break;
+            case '\b':
+                out.push_back('b');
+                break;
+            case '\f':
+                out.push_back('f');
+                break;
+            default:
+                out.insert(out.end(), {'u', '0', '0', HEX[c >> 4], HEX[c & 0xf]});
+                break;
+            }
+        }
+
+        void appendControlEscape(std::vector<char> &out, unsigned char c)
+        {
+            out.push_back('\\');
+            switch (c)
+            {
+            case '\\':
+                out.push_back('\\');
+                break;
+            case '\n':
+                out.push_back('n');
+                break;
+            case '\r':
+                out.push_back('r');
+                break;
+            case '\t':
+                out.push_back('t');
+                break;
+            default:
+                out.insert(out.end(), {'x', HEX[c >> 4], HEX[c & 0xf]});
+                break;
+            }
+        }
+
+        // copy clean runs in one insert each and escape the bytes in between
+        template <Scan S, typename Escape>
+        void appendEscaped(std::vector<char> &out, std::string_view str, Escape escape)
+        {
+            size_t pos = 0;
+            while (pos < str.size())
+            {
+                size_t next = scan<S>(str, pos);
+                size_t end = next == std::string_view::npos ? str.size() : next;
+
+                out.insert(out.end(), str.data() + pos, str.data() + end);
+                if (next == std::string_view::npos)
+                    break;
+
+                escape(out, static_cast<unsigned char>(str[next]));
+                pos = next + 1;
+            }
+        }
+    }
+
+    size_t findEscapable(std::string_view str, size_t from) noexcept
+    {
+        return scan<Scan::JSON>(str, from);
+    }
+
+    size_t findSanitizable(std::string_view str, size_t from) noexcept
+    {
+        return scan<Scan::SANITIZE>(str, from);
+    }
+
+    void appendJsonEscaped(std::vector<char> &out, std::string_view str)
+    {
+        appendEscaped<Scan::JSON>(out, str, appendJsonEscape);
+    }
+
+    void appendSanitized(std::vector<char> &out, std::string_view str)
+    {
+        appendEscaped<Scan::SANITIZE>(out, str, appendControlEscape);
+    }
+
+    void appendLogfmtValue(std::vector<char> &out, std::string_view str)
+    {
+        bool quote = str.empty() ||
+                     str.find_first_of(" =") != std::string_view::npos ||
+                     findEscapable(str) != std::string_view::npos;
+
+        if (!quote)
+        {
+            out.insert(out.end(), str.begin(), str.end());
+            return;
+        }
+
+        out.push_back('"');
+        appendJsonEscaped(out, str);
+        out.push_back('"');
+    }
+}
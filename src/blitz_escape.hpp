@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// escaping helpers for the structured (JSON/logfmt) layouts and text sanitization,
+// scanning 32/16 bytes at a time with AVX2/SSE2 on x86-64 and 8 bytes at a time elsewhere
+namespace blitz_escape
+{
+    // index of the first byte at or after `from` that needs escaping in a JSON string
+    // ('"', '\\' or a control character below 0x20), or std::string_view::npos
+    size_t findEscapable(std::string_view str, size_t from = 0) noexcept;
+
+    // index of the first byte at or after `from` that sanitizing escapes ('\\', a control character
+    // below 0x20 or DEL), or std::string_view::npos
+    size_t findSanitizable(std::string_view str, size_t from = 0) noexcept;
+
+    // append str with JSON string escaping, without surrounding quotes
+    void appendJsonEscaped(std::vector<char> &out, std::string_view str);
+
+    // append str with control characters replaced by C-style escapes (\n, \r, \t, \x1b) and '\\'
+    // doubled, so the original bytes can be recovered
+    void appendSanitized(std::vector<char> &out, std::string_view str);
+
+    // append str as a logfmt value, quoting it only when it contains spaces, '=', quotes or control characters
+    void appendLogfmtValue(std::vector<char> &out, std::string_view str);
+}
@@ -0,0 +1,120 @@
+#include "blitz_histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+
+namespace blitz_histogram
+{
+    size_t bucketIndex(uint64_t value) noexcept
+    {
+        if (value < LINEAR_LIMIT)
+            return static_cast<size_t>(value);
+
+        // the leading one selects the group, the next SUB_BUCKET_BITS bits the sub-bucket
+        const unsigned msb = static_cast<unsigned>(std::bit_width(value)) - 1;
+        const unsigned shift = msb - SUB_BUCKET_BITS;
+        const uint64_t sub = (value >> shift) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>(LINEAR_LIMIT + (msb - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + sub);
+    }
+
+    uint64_t bucketLow(size_t index) noexcept
+    {
+        if (index < LINEAR_LIMIT)
+            return index;
+
+        const uint64_t group = (index - LINEAR_LIMIT) / SUB_BUCKETS;
+        const uint64_t sub = (index - LINEAR_LIMIT) % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub) << (group + 1);
+    }
+
+    uint64_t bucketHigh(size_t index) noexcept
+    {
+        if (index < LINEAR_LIMIT)
+            return index;
+
+        const uint64_t group = (index - LINEAR_LIMIT) / SUB_BUCKETS;
+        return bucketLow(index) + ((uint64_t{1} << (group + 1)) - 1);
+    }
+
+    void Snapshot::merge(const Snapshot &other)
+    {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+            counts[i] += other.counts[i];
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    Snapshot Snapshot::since(const Snapshot &earlier) const
+    {
+        Snapshot delta;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            delta.counts[i] = counts[i] - std::min(counts[i], earlier.counts[i]);
+            if (delta.counts[i] == 0)
+                continue;
+            delta.min = std::min(delta.min, std::max(min, bucketLow(i)));
+            delta.max = std::max(delta.max, std::min(max, bucketHigh(i)));
+        }
+        delta.count = count - std::min(count, earlier.count);
+        delta.sum = sum - std::min(sum, earlier.sum);
+        return delta;
+    }
+
+    double Snapshot::mean() const
+    {
+        return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+    }
+
+    uint64_t Snapshot::percentile(double fraction) const
+    {
+        if (count == 0)
+            return 0;
+
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::clamp(bucketHigh(i), min, max);
+        }
+        return max;
+    }
+
+    std::string Snapshot::toJson() const
+    {
+        std::string json = std::format(
+            R"({{"count":{},"min":{},"max":{},"mean":{:.1f},"p50":{},"p90":{},"p99":{},"p999":{},"buckets":[)",
+            count, count ? min : 0, max, mean(),
+            percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999));
+
+        bool first = true;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            if (counts[i] == 0)
+                continue;
+            json += std::format("{}[{},{}]", first ? "" : ",", bucketHigh(i), counts[i]);
+            first = false;
+        }
+        json += "]}";
+        return json;
+    }
+
+    Snapshot Histogram::snapshot() const
+    {
+        Snapshot result;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            result.counts[i] = counts[i].load(std::memory_order_relaxed);
+            result.count += result.counts[i];
+        }
+        result.sum = sum.load(std::memory_order_relaxed);
+        result.min = min.load(std::memory_order_relaxed);
+        result.max = max.load(std::memory_order_relaxed);
+        return result;
+    }
+}
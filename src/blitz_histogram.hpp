@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// HDR-style latency histograms: exact below 64ns, then 32 linear sub-buckets per power of two,
+// so every recorded value is reported within ~3% over the full 64 bit range
+namespace blitz_histogram
+{
+    constexpr unsigned SUB_BUCKET_BITS = 5;
+    constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    constexpr uint64_t LINEAR_LIMIT = 2 * SUB_BUCKETS; // values below are counted exactly
+    constexpr size_t BUCKET_COUNT = LINEAR_LIMIT + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    size_t bucketIndex(uint64_t value) noexcept;
+
+    // smallest and largest value counted in a bucket
+    uint64_t bucketLow(size_t index) noexcept;
+    uint64_t bucketHigh(size_t index) noexcept;
+
+    // point in time copy of a histogram, snapshots of several histograms can be merged
+    struct Snapshot
+    {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(BUCKET_COUNT, 0);
+        uint64_t count{0};
+        uint64_t min{UINT64_MAX};
+        uint64_t max{0};
+        uint64_t sum{0};
+
+        void merge(const Snapshot &other);
+
+        // values recorded between an earlier snapshot of the same histogram and this one;
+        // min and max are the bounds of the lowest and highest non-empty buckets
+        Snapshot since(const Snapshot &earlier) const;
+        double mean() const;
+
+        // value at or below which the given fraction of the recorded values lie, 0 when empty
+        uint64_t percentile(double fraction) const;
+
+        // {"count":..,"min":..,"max":..,"mean":..,"p50":..,"p90":..,"p99":..,"p999":..,"buckets":[[high,count],...]}
+        std::string toJson() const;
+    };
+
+    // lock-free histogram with a single writer, readers may snapshot it at any time;
+    // recording is a few relaxed loads and stores without read-modify-write instructions
+    class Histogram
+    {
+    public:
+        void record(uint64_t value) noexcept
+        {
+            bump(counts[bucketIndex(value)], 1);
+            bump(sum, value);
+            if (value < min.load(std::memory_order_relaxed))
+                min.store(value, std::memory_order_relaxed);
+            if (value > max.load(std::memory_order_relaxed))
+                max.store(value, std::memory_order_relaxed);
+        }
+
+        Snapshot snapshot() const;
+
+    private:
+        static void bump(std::atomic<uint64_t> &counter, uint64_t by) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+    };
+}
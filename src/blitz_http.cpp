@@ -0,0 +1,252 @@
+#include "blitz_http.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace blitz_http
+{
+    namespace
+    {
+        constexpr int IO_TIMEOUT_MS = 1000; // per read/write, drops clients that stall
+        constexpr size_t MAX_REQUEST = 8192;
+
+        int listenUnix(const std::string &path)
+        {
+            sockaddr_un addr{};
+            if (path.size() >= sizeof(addr.sun_path))
+                throw std::runtime_error(std::format("Metrics socket path too long: {}", path));
+
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            ::unlink(path.c_str()); // left behind by an earlier run
+
+            int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0)
+            {
+                int error = errno;
+                if (fd >= 0)
+                    ::close(fd);
+                throw std::runtime_error(std::format("Failed to listen on {}: {}", path, std::strerror(error)));
+            }
+            return fd;
+        }
+
+        int listenTcp(const std::string &endpoint, std::string &bound)
+        {
+            auto colon = endpoint.rfind(':');
+            if (colon == std::string::npos)
+                throw std::runtime_error(std::format("Metrics endpoint needs host:port: {}", endpoint));
+
+            std::string host = endpoint.substr(0, colon);
+            std::string port = endpoint.substr(colon + 1);
+            if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+                host = host.substr(1, host.size() - 2);
+
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+            addrinfo *addresses = nullptr;
+            if (int rc = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses); rc != 0)
+                throw std::runtime_error(std::format("Failed to resolve {}: {}", endpoint, ::gai_strerror(rc)));
+
+            int fd = -1;
+            int error = 0;
+            for (addrinfo *ai = addresses; ai && fd < 0; ai = ai->ai_next)
+            {
+                fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+                if (fd < 0)
+                {
+                    error = errno;
+                    continue;
+                }
+
+                int on = 1;
+                ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+                if (::bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || ::listen(fd, 16) != 0)
+                {
+                    error = errno;
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+            ::freeaddrinfo(addresses);
+
+            if (fd < 0)
+                throw std::runtime_error(std::format("Failed to listen on {}: {}", endpoint, std::strerror(error)));
+
+            // report the port the kernel picked for port 0
+            sockaddr_storage addr{};
+            socklen_t length = sizeof(addr);
+            ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &length);
+            char name[INET6_ADDRSTRLEN] = {};
+            int actualPort = 0;
+            if (addr.ss_family == AF_INET6)
+            {
+                auto *in6 = reinterpret_cast<sockaddr_in6 *>(&addr);
+                ::inet_ntop(AF_INET6, &in6->sin6_addr, name, sizeof(name));
+                actualPort = ntohs(in6->sin6_port);
+                bound = std::format("[{}]:{}", name, actualPort);
+            }
+            else
+            {
+                auto *in4 = reinterpret_cast<sockaddr_in *>(&addr);
+                ::inet_ntop(AF_INET, &in4->sin_addr, name, sizeof(name));
+                actualPort = ntohs(in4->sin_port);
+                bound = std::format("{}:{}", name, actualPort);
+            }
+            return fd;
+        }
+
+        bool waitFor(int fd, short events)
+        {
+            pollfd pfd{fd, events, 0};
+            int rc;
+            do
+            {
+                rc = ::poll(&pfd, 1, IO_TIMEOUT_MS);
+            } while (rc < 0 && errno == EINTR);
+            return rc > 0;
+        }
+
+        void sendAll(int fd, std::string_view data)
+        {
+            while (!data.empty() && waitFor(fd, POLLOUT))
+            {
+                ssize_t sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+                if (sent < 0)
+                {
+                    if (errno == EINTR || errno == EAGAIN)
+                        continue;
+                    return;
+                }
+                data.remove_prefix(static_cast<size_t>(sent));
+            }
+        }
+    }
+
+    MetricsServer::MetricsServer(const std::string &endpoint, std::function<std::string()> renderMetrics,
+                                 std::function<void()> threadSetup)
+        : render(std::move(renderMetrics))
+    {
+        if (endpoint.starts_with("unix:"))
+        {
+            unixPath = endpoint.substr(5);
+            listenFd = listenUnix(unixPath);
+            boundEndpoint = endpoint;
+        }
+        else
+        {
+            listenFd = listenTcp(endpoint, boundEndpoint);
+        }
+
+        if (::pipe2(wakeFds, O_CLOEXEC) != 0)
+        {
+            ::close(listenFd);
+            throw std::runtime_error(std::format("Failed to create metrics server pipe: {}", std::strerror(errno)));
+        }
+
+        thread = std::thread([this, threadSetup = std::move(threadSetup)]()
+                             {
+            if (threadSetup)
+                threadSetup();
+            run(); });
+    }
+
+    MetricsServer::~MetricsServer()
+    {
+        if (thread.joinable())
+        {
+            char stop = 0;
+            (void)::write(wakeFds[1], &stop, 1);
+            thread.join();
+        }
+
+        ::close(wakeFds[0]);
+        ::close(wakeFds[1]);
+        ::close(listenFd);
+        if (!unixPath.empty())
+            ::unlink(unixPath.c_str());
+    }
+
+    void MetricsServer::run()
+    {
+        std::array<pollfd, 2> fds = {pollfd{listenFd, POLLIN, 0}, pollfd{wakeFds[0], POLLIN, 0}};
+        while (true)
+        {
+            if (::poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            if (fds[1].revents)
+                return; // stopping
+
+            if (fds[0].revents & POLLIN)
+            {
+                int client = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                if (client >= 0)
+                {
+                    serve(client);
+                    ::close(client);
+                }
+            }
+        }
+    }
+
+    void MetricsServer::serve(int client)
+    {
+        // the request line and headers are all we read, a scrape has no body
+        std::string request;
+        char chunk[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST)
+        {
+            if (!waitFor(client, POLLIN))
+                return;
+            ssize_t received = ::recv(client, chunk, sizeof(chunk), 0);
+            if (received < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (received <= 0)
+                return;
+            request.append(chunk, static_cast<size_t>(received));
+        }
+
+        std::string_view line(request);
+        line = line.substr(0, line.find("\r\n"));
+
+        std::string_view status = "200 OK";
+        std::string body;
+        if (!line.starts_with("GET "))
+        {
+            status = "405 Method Not Allowed";
+        }
+        else if (line.starts_with("GET /metrics ") || line.starts_with("GET /metrics?") || line.starts_with("GET / "))
+        {
+            body = render();
+        }
+        else
+        {
+            status = "404 Not Found";
+        }
+
+        sendAll(client, std::format("HTTP/1.1 {}\r\n"
+                                    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                    "Content-Length: {}\r\n"
+                                    "Connection: close\r\n\r\n",
+                                    status, body.size()));
+        sendAll(client, body);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+
+// minimal HTTP/1.1 server for the metrics endpoint, serving one short lived connection at a time
+// on its own thread, so a slow or stuck scraper never reaches the logger or the producers
+namespace blitz_http
+{
+    class MetricsServer
+    {
+    public:
+        // listens on "host:port" (port 0 picks a free port) or "unix:/path/to.sock" and answers
+        // GET /metrics with render(); threadSetup runs first on the server thread; throws
+        // std::runtime_error if the endpoint cannot be bound
+        MetricsServer(const std::string &endpoint, std::function<std::string()> render,
+                      std::function<void()> threadSetup = nullptr);
+        ~MetricsServer();
+
+        MetricsServer(const MetricsServer &) = delete;
+        MetricsServer &operator=(const MetricsServer &) = delete;
+
+        // endpoint as bound, with the actual port
+        const std::string &endpoint() const { return boundEndpoint; }
+
+    private:
+        void run();
+        void serve(int client);
+
+        std::function<std::string()> render;
+        std::string boundEndpoint;
+        std::string unixPath; // removed again on shutdown
+        int listenFd{-1};
+        int wakeFds[2]{-1, -1}; // self-pipe to stop the poll loop
+        std::thread thread;
+    };
+}
@@ -1,38 +1,291 @@
 #include "blitz_logger.hpp"
+#include "blitz_escape.hpp"
+#include "blitz_numa.hpp"
+#include <charconv>
+#include <random>
+#include <functional>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <utility>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 Logger::BufferRegistry Logger::bufferRegistry;
 
+Logger::ThreadLocalBuffer::ThreadLocalBuffer(size_t requestedCapacity, std::shared_ptr<BufferArena> from, int node)
+    : capacity(roundCapacity(requestedCapacity)), numaNode(node), ownerThreadId(std::this_thread::get_id())
+{
+    if (from)
+    {
+        BufferArena::FreeRing ring = from->acquire(capacity, node);
+        slots = ring.slots;
+        if (slots)
+            numaNode = ring.node;
+        arena = std::move(from);
+    }
+
+    if (!slots)
+        slots = allocateSlots(capacity, node);
+}
+
+Logger::ThreadLocalBuffer::~ThreadLocalBuffer()
+{
+    for (size_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); i = (i + 1) & (capacity - 1))
+        at(i).~LogMessage();
+
+    if (arena)
+        arena->release({slots, capacity, numaNode});
+    else
+        freeSlots(slots, capacity);
+    delete offeredRing.load(std::memory_order_acquire); // the thread exited before taking it
+}
+
+Logger::ThreadLocalBuffer::Slot *Logger::ThreadLocalBuffer::allocateSlots(size_t capacity, int node)
+{
+    void *memory = blitz_numa::map(capacity * sizeof(Slot), node);
+    if (!memory)
+        throw std::bad_alloc();
+    return static_cast<Slot *>(memory);
+}
+
+void Logger::ThreadLocalBuffer::freeSlots(Slot *slots, size_t capacity) noexcept
+{
+    blitz_numa::unmap(slots, capacity * sizeof(Slot));
+}
+
+Logger::BufferArena::BufferArena(size_t rings, size_t ringCapacity, size_t pooledRings, bool spreadNodes)
+    : capacity(ringCapacity), maxPooled(pooledRings)
+{
+    usedRings.reserve(rings + pooledRings);
+    if (rings == 0)
+        return;
+
+    const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t ringBytes = (capacity * sizeof(Slot) + pageSize - 1) / pageSize * pageSize;
+    const int nodes = spreadNodes ? blitz_numa::nodeCount() : 1;
+    bytes = rings * ringBytes;
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if (nodes == 1)
+        flags |= MAP_POPULATE; // fault everything in now rather than on the producers' first messages
+#endif
+    memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error(std::format("Failed to map {} bytes for ring buffers: {}", bytes, std::strerror(errno)));
+    }
+
+    freeRings.reserve(rings);
+    for (size_t i = rings; i-- > 0;)
+    {
+        auto *ring = static_cast<char *>(memory) + i * ringBytes;
+        int node = -1;
+        if (nodes > 1)
+        {
+            // bound before the first touch, which then faults the pages in on that node
+            node = static_cast<int>(i % static_cast<size_t>(nodes));
+            blitz_numa::preferNode(ring, ringBytes, node);
+            for (size_t offset = 0; offset < ringBytes; offset += pageSize)
+                ring[offset] = 0;
+        }
+        freeRings.push_back({reinterpret_cast<Slot *>(ring), capacity, node});
+    }
+}
+
+Logger::BufferArena::~BufferArena()
+{
+    for (const FreeRing &ring : usedRings)
+    {
+        if (!owns(ring.slots))
+            ThreadLocalBuffer::freeSlots(ring.slots, ring.capacity);
+    }
+    if (memory)
+        ::munmap(memory, bytes);
+}
+
+bool Logger::BufferArena::owns(const Slot *ring) const noexcept
+{
+    const auto *begin = static_cast<const char *>(memory);
+    const auto *address = reinterpret_cast<const char *>(ring);
+    return memory && std::less_equal<>{}(begin, address) && std::less<>{}(address, begin + bytes);
+}
+
+// a released ring has its pages faulted in already, so it goes out before a fresh mapped one; a
+// fresh ring on another node still beats allocating, a released one faulted in there does not
+Logger::BufferArena::FreeRing Logger::BufferArena::acquire(size_t ringCapacity, int node)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = usedRings.rbegin(); it != usedRings.rend(); ++it)
+    {
+        if (it->capacity != ringCapacity || (node >= 0 && it->node != node))
+            continue;
+
+        FreeRing ring = *it;
+        usedRings.erase(std::next(it).base());
+        if (!owns(ring.slots))
+            pooledAllocations--;
+        reused.fetch_add(1, std::memory_order_relaxed);
+        return ring;
+    }
+
+    if (ringCapacity != capacity || freeRings.empty())
+        return {};
+
+    auto it = std::find_if(freeRings.rbegin(), freeRings.rend(), [node](const FreeRing &ring)
+                           { return ring.node == node; });
+    auto taken = it != freeRings.rend() ? std::next(it).base() : std::prev(freeRings.end());
+    FreeRing ring = *taken;
+    freeRings.erase(taken);
+    return ring;
+}
+
+void Logger::BufferArena::release(const FreeRing &ring)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (owns(ring.slots))
+        {
+            usedRings.push_back(ring);
+            return;
+        }
+        if (pooledAllocations < maxPooled)
+        {
+            usedRings.push_back(ring);
+            pooledAllocations++;
+            return;
+        }
+    }
+    ThreadLocalBuffer::freeSlots(ring.slots, ring.capacity);
+}
+
+// cleanup on thread exit, the ring stays registered until the logger thread has written what is left in it
+Logger::LocalBuffer::~LocalBuffer()
+{
+    if (buffer)
+        buffer->isActive.store(false, std::memory_order_release);
+}
+
+Logger::LocalBuffer &Logger::localBuffer()
+{
+    static thread_local LocalBuffer local;
+    return local;
+}
+
+// node for a ring of the calling thread, the first touch would put the pages there anyway, binding
+// also covers rings the logger thread allocates and keeps the pool from handing out remote ones
+int Logger::ringNode() const noexcept
+{
+    return config.numaLocalBuffers ? blitz_numa::currentNode() : -1;
+}
+
 // thread local buffer
 Logger::ThreadLocalBuffer &Logger::getThreadLocalBuffer()
 {
-    static thread_local std::shared_ptr<ThreadLocalBuffer> localBuffer = nullptr;
+    LocalBuffer &local = localBuffer();
+
+    if (!local.buffer) [[unlikely]]
+    {
+        local.buffer = std::make_shared<ThreadLocalBuffer>(local.capacity ? local.capacity : config.bufferCapacity, bufferArena, ringNode());
+        local.buffer->fixedCapacity.store(local.capacity != 0, std::memory_order_relaxed);
+        bufferRegistry.registerBuffer(local.buffer);
+    }
+    else if (local.buffer->offeredRing.load(std::memory_order_relaxed)) [[unlikely]]
+    {
+        std::shared_ptr<ThreadLocalBuffer> next(local.buffer->offeredRing.exchange(nullptr, std::memory_order_acquire));
+        switchThreadBuffer(local, std::move(next));
+    }
+
+    return *local.buffer;
+}
+
+// runs on the owning thread between two pushes, so nothing lands in the old ring after this
+void Logger::switchThreadBuffer(LocalBuffer &local, std::shared_ptr<ThreadLocalBuffer> next)
+{
+    const ThreadLocalBuffer &old = *local.buffer;
+    next->ownerThreadId = old.ownerThreadId;
+    next->blockedPushes.store(old.blockedPushes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    next->yieldSpins.store(old.yieldSpins.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    next->blockedPushesSeen = next->blockedPushes.load(std::memory_order_relaxed);
+    next->predecessor = local.buffer;
+
+    bufferRegistry.replaceBuffer(local.buffer, next);
+    local.buffer = std::move(next);
+}
+
+void Logger::setThreadBufferCapacity(size_t capacity)
+{
+    LocalBuffer &local = localBuffer();
+    local.capacity = capacity;
+
+    if (!local.buffer)
+        return;
 
-    if (!localBuffer)
+    // 0 goes back to the configured capacity, which may grow again
+    const bool fixed = capacity != 0;
+    const size_t target = fixed ? capacity : config.bufferCapacity;
+    if (local.buffer->capacity == ThreadLocalBuffer::roundCapacity(target))
     {
-        localBuffer = std::make_shared<ThreadLocalBuffer>();
-        bufferRegistry.registerBuffer(localBuffer);
+        local.buffer->fixedCapacity.store(fixed, std::memory_order_relaxed);
+        return;
+    }
+    auto next = std::make_shared<ThreadLocalBuffer>(target, bufferArena, ringNode());
+    next->fixedCapacity.store(fixed, std::memory_order_relaxed);
+    switchThreadBuffer(local, std::move(next));
+}
 
-        // register cleanup on thread exit
-        static thread_local struct ThreadCleanup
-        {
-            std::shared_ptr<ThreadLocalBuffer> buffer;
-            ThreadCleanup(std::shared_ptr<ThreadLocalBuffer> buf) : buffer(buf) {}
-            ~ThreadCleanup()
-            {
-                if (buffer)
-                {
-                    buffer->isActive.store(false, std::memory_order_release);
-                    bufferRegistry.unregisterBuffer(buffer);
-                }
-            }
-        } cleanup(localBuffer);
+// a thread that keeps finding its ring full gets one twice the size, allocated here so that the
+// producer only swaps pointers on its next log call
+void Logger::offerLargerRing(ThreadLocalBuffer &buffer)
+{
+    constexpr uint64_t GROW_AFTER_BLOCKED_PUSHES = 4;
+
+    const uint64_t blocked = buffer.blockedPushes.load(std::memory_order_relaxed);
+    if (buffer.fixedCapacity.load(std::memory_order_relaxed) || blocked - buffer.blockedPushesSeen < GROW_AFTER_BLOCKED_PUSHES ||
+        buffer.capacity * 2 > config.maxBufferCapacity ||
+        buffer.offeredRing.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    buffer.blockedPushesSeen = blocked;
+
+    try
+    {
+        buffer.offeredRing.store(new ThreadLocalBuffer(buffer.capacity * 2, bufferArena, buffer.numaNode), std::memory_order_release);
+        counters.bufferGrowths.fetch_add(1, std::memory_order_relaxed);
+    }
+    catch (const std::bad_alloc &)
+    {
+        // keep the current ring
+    }
+}
+
+// best effort, a thread that cannot be renamed or moved still does its work
+void Logger::applyThreadOptions(const blitz_thread::Options &options)
+{
+    if (auto failures = blitz_thread::apply(options); !failures.empty())
+    {
+        std::cerr << std::format("Failed to apply thread options to {}: {}\n", options.name.empty() ? "thread" : options.name, failures);
     }
+}
 
-    return *localBuffer;
+// runs on the logger thread once an exited thread's ring is empty, the ring is freed with the
+// last reference, usually the logger thread's own copy of the registry
+void Logger::retireBuffer(const std::shared_ptr<ThreadLocalBuffer> &buffer)
+{
+    // the ring's counts move to the totals in the same step, so metrics() never sees them go backwards
+    std::lock_guard<std::mutex> lock(bufferRegistry.registryMutex);
+    bufferRegistry.buffers.remove(buffer);
+    counters.retiredBlockedPushes.fetch_add(buffer->blockedPushes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    counters.retiredYieldSpins.fetch_add(buffer->yieldSpins.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    counters.buffersRetired.fetch_add(1, std::memory_order_relaxed);
 }
 
 // default constructor
@@ -42,6 +295,13 @@ Logger::Logger() : config(Config{}), running(true)
 
 void Logger::processLogs()
 {
+    // first, so the batch and output buffers below are touched on that node too
+    if (config.loggerNumaNode >= 0 && !blitz_numa::runOnNode(config.loggerNumaNode))
+    {
+        std::cerr << std::format("Failed to pin the logger thread to NUMA node {}\n", config.loggerNumaNode);
+    }
+    applyThreadOptions(config.loggerThreadOptions);
+
     constexpr size_t BATCH_SIZE = 16384; // 16KB batch size
     std::vector<LogMessage> batchBuffer;
     batchBuffer.reserve(BATCH_SIZE);
@@ -51,50 +311,92 @@ void Logger::processLogs()
     std::vector<char> consoleBuffer;
     consoleBuffer.reserve(2 * 1024 * 1024); // 2MB console buffer
 
+    uint64_t flushGeneration = 0;
+
     while (running.load(std::memory_order_relaxed))
     {
         bool messagesProcessed = false;
         bool anyBufferNearlyFull = false;
 
+        if (uint64_t requested = flushBarrier.requested.load(std::memory_order_acquire); requested != flushGeneration)
+        {
+            flushGeneration = requested;
+            completeFlush(flushGeneration, batchBuffer, fileBuffer, consoleBuffer);
+        }
+
         auto buffers = bufferRegistry.getAllBuffers(); // round-robin access to all buffers
         for (auto &buffer : buffers)
         {
-            if (!buffer->isActive.load(std::memory_order_relaxed))
-                continue;
+            // read before popping, so that an empty ring below means the exited owner's last message is out
+            const bool exited = !buffer->isActive.load(std::memory_order_acquire);
 
             // check if any buffer is nearly full
             if (buffer->isNearlyFull())
             {
                 anyBufferNearlyFull = true;
             }
+            if (!exited && config.maxBufferCapacity > buffer->capacity)
+            {
+                offerLargerRing(*buffer);
+            }
 
-            LogMessage msg;
-            size_t messagesFromThisBuffer = 0;
+            // process messages from this buffer, head is published once per buffer and pass
             const size_t maxMessagesPerBuffer = BATCH_SIZE / std::max(buffers.size(), size_t(1));
-
-            // process messages from this buffer
-            while (messagesFromThisBuffer < maxMessagesPerBuffer &&
-                   batchBuffer.size() < BATCH_SIZE &&
-                   buffer->pop(msg))
+            if (buffer->popBatch(batchBuffer, std::min(maxMessagesPerBuffer, BATCH_SIZE - batchBuffer.size())) > 0)
             {
-                batchBuffer.push_back(std::move(msg));
                 messagesProcessed = true;
-                messagesFromThisBuffer++;
+            }
+
+            if (exited && !buffer->predecessor && buffer->isEmpty())
+            {
+                retireBuffer(buffer);
             }
         }
-        if (!batchBuffer.empty())
+        const bool idle = batchBuffer.empty();
+        if (!idle)
         {
             processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
-        } // adaptive sleep: short sleep for high pressure, longer for low pressure
+        }
+        else if (duplicateFilter.pendingEntries > 0)
+        {
+            // no new messages, but repeat summaries may be due
+            processMessageBatch(batchBuffer, fileBuffer, consoleBuffer);
+            fileBuffer.clear();
+            consoleBuffer.clear();
+        }
+
+        // idle work runs on every pass without new messages, a pending repeat summary must not delay it
+        if (idle)
+        {
+            // no new messages, don't hold output back indefinitely
+            const bool flushed = pendingOutputDue(std::chrono::steady_clock::now());
+            if (flushed)
+            {
+                flushPendingOutput();
+            }
+            if (flushed || rotationRequested.load(std::memory_order_relaxed))
+            {
+                rotateLogFileIfNeeded();
+            }
+            if (unsyncedWrites && config.syncIntervalMs > 0)
+            {
+                syncLogFile(false);
+            }
+        }
+
+        // adaptive sleep: short sleep for high pressure, longer for low pressure
         if (!messagesProcessed)
         {
             auto sleep_duration = anyBufferNearlyFull ? std::chrono::microseconds(10) : std::chrono::microseconds(100);
-            std::this_thread::sleep_for(sleep_duration);
+            std::unique_lock lock(flushBarrier.mutex);
+            flushBarrier.wakeup.wait_for(lock, sleep_duration, [&]
+                                         { return flushBarrier.requested.load(std::memory_order_relaxed) != flushGeneration; });
         }
     }
 
-    // drain remaining messages before shutdown
+    // drain remaining messages before shutdown, which also satisfies every flush() still waiting
     drainAllBuffers(batchBuffer, fileBuffer, consoleBuffer);
+    completeFlush(flushBarrier.requested.load(std::memory_order_acquire), batchBuffer, fileBuffer, consoleBuffer);
 }
 
 void Logger::processMessageBatch(
@@ -102,235 +404,1467 @@ void Logger::processMessageBatch(
     std::vector<char> &fileBuffer,
     std::vector<char> &consoleBuffer)
 {
+    if (!batch.empty())
+    {
+        counters.messagesConsumed.fetch_add(batch.size(), std::memory_order_relaxed);
+        counters.batchSizes.record(batch.size());
+    }
+
+    const bool timed = config.latencyHistograms && !batch.empty();
+    const auto formatStart = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+    bool urgent = false; // batch has to be on disk before the logger thread moves on
     for (const auto &msg : batch)
     {
-        if (config.fileOutput)
+        // messages logged before latencyHistograms was turned on carry no stamp
+        if (timed && msg.calledAt != std::chrono::steady_clock::time_point{})
+            stageHistograms.queue.record(elapsedNs(msg.calledAt, formatStart));
+
+        if (config.deduplicateMessages && suppressDuplicate(msg, fileBuffer, consoleBuffer))
+            continue;
+
+        appendMessage(msg, fileBuffer, consoleBuffer);
+        urgent |= config.syncOnError && (msg.level == Level::ERROR || msg.level == Level::FATAL);
+    }
+
+    if (timed)
+    {
+        stageHistograms.format.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - formatStart).count()));
+    }
+
+    if (config.deduplicateMessages)
+    {
+        flushRepeatedMessages(false, fileBuffer, consoleBuffer);
+    }
+
+    writeOutput(fileBuffer, consoleBuffer, urgent);
+
+    // held back output (flushIntervalMs, live compression) counts as written once it is queued
+    if (timed)
+    {
+        const auto writtenAt = std::chrono::steady_clock::now();
+        for (const auto &msg : batch)
+        {
+            if (msg.calledAt != std::chrono::steady_clock::time_point{})
+                stageHistograms.endToEnd.record(elapsedNs(msg.calledAt, writtenAt));
+        }
+    }
+}
+
+// hands rendered output to the sinks, on the logger thread or under syncMutex in synchronous mode
+void Logger::writeOutput(const std::vector<char> &fileBuffer, const std::vector<char> &consoleBuffer, bool urgent)
+{
+    if (config.fileOutput && !fileBuffer.empty())
+    {
+        rotateLogFileIfNeeded(); // a new time period starts in a new file
+        writeToLogFile(fileBuffer);
+        if (urgent || (unsyncedWrites && config.syncIntervalMs > 0))
+            syncLogFile(urgent);
+        rotateLogFileIfNeeded();
+    }
+
+    if (config.consoleOutput && !consoleBuffer.empty())
+    {
+        std::cout.write(consoleBuffer.data(), consoleBuffer.size());
+        counters.consoleBytes.fetch_add(consoleBuffer.size(), std::memory_order_relaxed);
+    }
+}
+
+// synchronous mode: text is rendered into the caller's own buffers before taking the lock, binary
+// records and duplicate suppression depend on state shared by all threads and are built under it
+void Logger::writeSynchronous(const LogMessage &msg)
+{
+    thread_local std::vector<char> fileBuffer;
+    thread_local std::vector<char> consoleBuffer;
+    fileBuffer.clear();
+    consoleBuffer.clear();
+
+    const bool sharedState = config.binaryOutput || config.deduplicateMessages;
+    if (!sharedState)
+        appendMessage(msg, fileBuffer, consoleBuffer);
+
+    std::lock_guard<std::mutex> lock(syncMutex);
+    if (sharedState)
+    {
+        if (!config.deduplicateMessages || !suppressDuplicate(msg, fileBuffer, consoleBuffer))
+            appendMessage(msg, fileBuffer, consoleBuffer);
+        if (config.deduplicateMessages)
+            flushRepeatedMessages(false, fileBuffer, consoleBuffer);
+    }
+
+    counters.messagesConsumed.fetch_add(1, std::memory_order_relaxed);
+    writeOutput(fileBuffer, consoleBuffer, config.syncOnError && (msg.level == Level::ERROR || msg.level == Level::FATAL));
+
+    if (config.latencyHistograms && msg.calledAt != std::chrono::steady_clock::time_point{})
+        stageHistograms.endToEnd.record(elapsedNs(msg.calledAt, std::chrono::steady_clock::now()));
+}
+
+// synchronous counterpart of completeFlush() and the final drain: held back output, and at
+// shutdown the repeat summaries still inside their window
+void Logger::flushSynchronous(bool sync, bool shutdown)
+{
+    std::vector<char> fileBuffer;
+    std::vector<char> consoleBuffer;
+
+    std::lock_guard<std::mutex> lock(syncMutex);
+    if (shutdown && duplicateFilter.pendingEntries > 0)
+    {
+        flushRepeatedMessages(true, fileBuffer, consoleBuffer);
+        writeOutput(fileBuffer, consoleBuffer, false);
+    }
+
+    if (config.fileOutput && logFd >= 0)
+    {
+        flushPendingOutput();
+        if (sync)
+            syncLogFile(true);
+    }
+    if (config.consoleOutput)
+    {
+        std::cout.flush();
+    }
+}
+
+void Logger::appendMessage(
+    const LogMessage &msg,
+    std::vector<char> &fileBuffer,
+    std::vector<char> &consoleBuffer)
+{
+    if (config.fileOutput)
+    {
+        if (config.binaryOutput)
+        {
+            encodeBinaryMessage(msg, fileBuffer);
+        }
+        else
         {
             formatLogMessage(msg, fileBuffer);
             std::back_inserter(fileBuffer)++ = '\n';
         }
+    }
+
+    if (config.consoleOutput)
+    {
+        if (config.useColors)
+        {
+            const char *color = getLevelColor(msg.level);
+            size_t color_len = std::strlen(color);
+            std::copy_n(color, color_len, std::back_inserter(consoleBuffer));
+        }
+
+        formatLogMessage(msg, consoleBuffer);
 
-        if (config.consoleOutput)
+        if (config.useColors)
         {
-            if (config.useColors)
-            {
-                const char *color = getLevelColor(msg.level);
-                size_t color_len = std::strlen(color);
-                std::copy_n(color, color_len, std::back_inserter(consoleBuffer));
-            }
+            const char *reset = COLORS[COLOR_RESET];
+            size_t reset_len = std::strlen(reset);
+            std::copy_n(reset, reset_len, std::back_inserter(consoleBuffer));
+        }
+        std::back_inserter(consoleBuffer)++ = '\n';
+    }
+}
+
+void Logger::appendRepeatSummary(
+    const DuplicateFilter::Entry &entry,
+    std::vector<char> &fileBuffer,
+    std::vector<char> &consoleBuffer)
+{
+    LogMessage summary{
+        std::format("Message repeated {} times: {}", entry.repeats,
+                    blitz_binary::renderPayload(entry.format, entry.message)),
+        entry.level,
+        entry.context};
+    summary.fields = entry.fields;
+    appendMessage(summary, fileBuffer, consoleBuffer);
+}
+
+// returns true if msg repeats a message from the same call site within the dedup window
+bool Logger::suppressDuplicate(
+    const LogMessage &msg,
+    std::vector<char> &fileBuffer,
+    std::vector<char> &consoleBuffer)
+{
+    size_t key = std::hash<std::string_view>{}(msg.message);
+    key ^= std::hash<std::string_view>{}(msg.context.file) + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2);
+    key ^= static_cast<size_t>(msg.context.line) * 0x9e3779b97f4a7c15ULL;
+
+    auto &entry = duplicateFilter.entries[key & (DuplicateFilter::TABLE_SIZE - 1)];
+    const auto window = std::chrono::milliseconds(config.dedupWindowMs);
+
+    if (entry.used && entry.key == key &&
+        entry.context.line == msg.context.line &&
+        entry.message == msg.message &&
+        entry.format.data() == msg.format.data() &&
+        entry.fields == msg.fields &&
+        entry.context.file == msg.context.file &&
+        msg.timestamp - entry.firstSeen < window)
+    {
+        if (entry.repeats++ == 0)
+            duplicateFilter.pendingEntries++;
+        return true;
+    }
+
+    // slot is taken by another message or the window expired: report and reuse it
+    if (entry.used && entry.repeats > 0)
+    {
+        appendRepeatSummary(entry, fileBuffer, consoleBuffer);
+        duplicateFilter.pendingEntries--;
+    }
+
+    entry.key = key;
+    entry.used = true;
+    entry.repeats = 0;
+    entry.level = msg.level;
+    entry.context = msg.context;
+    entry.message.assign(msg.message);
+    entry.format = msg.format;
+    entry.fields.assign(msg.fields);
+    entry.firstSeen = msg.timestamp;
+    return false;
+}
+
+// emit "repeated N times" lines for entries whose window expired (or all of them when forced)
+void Logger::flushRepeatedMessages(
+    bool force,
+    std::vector<char> &fileBuffer,
+    std::vector<char> &consoleBuffer)
+{
+    if (duplicateFilter.pendingEntries == 0)
+        return;
+
+    const auto now = std::chrono::system_clock::now();
+    const auto window = std::chrono::milliseconds(config.dedupWindowMs);
+
+    for (auto &entry : duplicateFilter.entries)
+    {
+        if (!entry.used || entry.repeats == 0 || (!force && now - entry.firstSeen < window))
+            continue;
+
+        appendRepeatSummary(entry, fileBuffer, consoleBuffer);
 
-            formatLogMessage(msg, consoleBuffer);
+        entry.used = false;
+        entry.repeats = 0;
+        duplicateFilter.pendingEntries--;
+    }
+}
 
-            if (config.useColors)
+void Logger::drainAllBuffers(
+    std::vector<LogMessage> &batchBuffer,
+    std::vector<char> &fileBuffer,
+    std::vector<char> &consoleBuffer)
+{
+    auto buffers = bufferRegistry.getAllBuffers();
+    for (auto &buffer : buffers)
+    {
+        while (buffer->popBatch(batchBuffer, 4096 - batchBuffer.size()) > 0)
+        {
+            if (batchBuffer.size() >= 4096)
             {
-                const char *reset = COLORS[COLOR_RESET];
-                size_t reset_len = std::strlen(reset);
-                std::copy_n(reset, reset_len, std::back_inserter(consoleBuffer));
+                processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
             }
-            std::back_inserter(consoleBuffer)++ = '\n';
         }
     }
-    if (config.fileOutput && !fileBuffer.empty())
+    processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
+
+    // report repeats still inside their window
+    if (duplicateFilter.pendingEntries > 0)
     {
-        logFile.write(fileBuffer.data(), fileBuffer.size());
-        currentFileSize += fileBuffer.size();
-        rotateLogFileIfNeeded();
+        flushRepeatedMessages(true, fileBuffer, consoleBuffer);
+        processMessageBatch(batchBuffer, fileBuffer, consoleBuffer);
+        fileBuffer.clear();
+        consoleBuffer.clear();
+    }
+
+    // final flush to ensure all data is written to disk
+    if (config.fileOutput && logFd >= 0)
+    {
+        flushPendingOutput();
+        if (syncEnabled())
+            syncLogFile(true);
     }
+}
+
+void Logger::updateThreadStats(std::chrono::steady_clock::time_point calledAt)
+{
+    auto threadId = std::this_thread::get_id();
+    const bool timed = config.latencyHistograms && calledAt != std::chrono::steady_clock::time_point{};
+    const uint64_t latencyNs = timed ? elapsedNs(calledAt, std::chrono::steady_clock::now()) : 0;
+
+    std::lock_guard<std::mutex> lock(statsMapMutex);
+    auto [it, inserted] = threadStatsMap.try_emplace(threadId, std::make_shared<ThreadStats>());
+
+    if (inserted)
+    {
+        it->second->threadId = threadId;
+    }
+    it->second->messagesProduced.fetch_add(1, std::memory_order_relaxed);
+    if (timed)
+        it->second->producerLatency.record(latencyNs);
+}
+void Logger::formatLogMessage(const LogMessage &msg, std::vector<char> &buffer) noexcept
+{
+    std::string rendered;
+    std::string_view text = msg.message;
+
+    // binary encoded messages still need text for the console
+    if (!msg.format.empty())
+    {
+        try
+        {
+            rendered = blitz_binary::renderPayload(msg.format, msg.message);
+        }
+        catch (const std::exception &e)
+        {
+            rendered = std::format("<undecodable message: {}>", e.what());
+        }
+        text = rendered;
+    }
+
+    formatRecord(config,
+                 {msg.level,
+                  msg.timestamp,
+                  std::hash<std::thread::id>{}(msg.context.threadId),
+                  msg.context.module,
+                  msg.context.file,
+                  msg.context.line,
+                  text,
+                  msg.fields},
+                 buffer);
+}
+
+void Logger::formatRecord(const Config &config, const RecordView &msg, std::vector<char> &buffer) noexcept
+{
+    try
+    {
+        if (config.layout == Layout::JSON)
+            return formatJsonRecord(config, msg, buffer);
+        if (config.layout == Layout::LOGFMT)
+            return formatLogfmtRecord(config, msg, buffer);
+    }
+    catch (const std::exception &)
+    {
+        // structured layouts only throw on corrupt field payloads, fall back to text
+    }
+
+    // calculate total required size to avoid reallocation
+    size_t required_size = 256 + msg.message.size(); // base size
+
+    if (config.showTimestamp)
+        required_size += 32; // timestamp needs about 32 bytes
+    if (config.showThreadId)
+        required_size += 32; // thread id needs about 32 bytes
+    if (config.showModuleName && !msg.module.empty())
+        required_size += msg.module.size() + 3; // module name + "[] "
+    if (config.showSourceLocation)
+        required_size += msg.file.size() + 10; // file name + line number + "[] "
+
+    // reserve space once
+    size_t original_size = buffer.size();
+    buffer.reserve(original_size + required_size);
+
+    // use back_inserter to avoid repeated insert calls
+    auto inserter = std::back_inserter(buffer);
+
+    // format timestamp
+    if (config.showTimestamp) [[likely]]
+    {
+        auto time = std::chrono::system_clock::to_time_t(msg.timestamp);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      msg.timestamp.time_since_epoch()) %
+                  1000;
+
+        char time_buffer[64];
+        size_t time_len = std::strftime(time_buffer, sizeof(time_buffer),
+                                        "[%Y-%m-%d %H:%M:%S.", std::localtime(&time));
+
+        // format milliseconds and closing bracket
+        int ms_len = std::snprintf(time_buffer + time_len, sizeof(time_buffer) - time_len,
+                                   "%03d] ", static_cast<int>(ms.count()));
+
+        std::copy_n(time_buffer, time_len + ms_len, inserter);
+    }
+
+    // format log level
+    const auto &level_str = LEVEL_STRINGS[static_cast<size_t>(msg.level)];
+    *inserter++ = '[';
+    std::copy(level_str.begin(), level_str.end(), inserter);
+    *inserter++ = ']';
+    *inserter++ = ' ';
+
+    // format thread id
+    if (config.showThreadId) [[likely]]
+    {
+        char thread_buffer[32];
+        int thread_len = std::snprintf(thread_buffer, sizeof(thread_buffer),
+                                       "[T-%zu] ",
+                                       msg.threadHash);
+        std::copy_n(thread_buffer, thread_len, inserter);
+    }
+
+    // format module name
+    if (config.showModuleName && !msg.module.empty()) [[likely]]
+    {
+        *inserter++ = '[';
+        std::copy(msg.module.begin(), msg.module.end(), inserter);
+        *inserter++ = ']';
+        *inserter++ = ' ';
+    }
+
+    // format source location
+    if (config.showSourceLocation) [[likely]]
+    {
+        std::string_view file(msg.file);
+        if (!config.showFullPath) [[likely]]
+        {
+            if (auto pos = file.find_last_of("/\\"); pos != std::string_view::npos)
+                file = file.substr(pos + 1);
+        }
+
+        *inserter++ = '[';
+        std::copy(file.begin(), file.end(), inserter);
+
+        char line_buffer[16];
+        int line_len = std::snprintf(line_buffer, sizeof(line_buffer),
+                                     ":%d] ", msg.line);
+        std::copy_n(line_buffer, line_len, inserter);
+    }
+
+    // append message content, keeping one record per line when sanitizing
+    if (config.sanitizeMessages)
+        blitz_escape::appendSanitized(buffer, msg.message);
+    else
+        std::copy(msg.message.begin(), msg.message.end(), inserter);
+
+    // append structured fields as key=value
+    if (!msg.fields.empty())
+    {
+        try
+        {
+            appendFields(msg.fields, false, buffer);
+        }
+        catch (const std::exception &)
+        {
+            // corrupt field payload, keep the message itself
+        }
+    }
+}
+
+namespace
+{
+    // ISO 8601 UTC timestamp with milliseconds, e.g. 2024-01-31T12:00:00.123Z
+    void appendIsoTimestamp(std::vector<char> &buffer, std::chrono::system_clock::time_point timestamp)
+    {
+        auto time = std::chrono::system_clock::to_time_t(timestamp);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      timestamp.time_since_epoch()) %
+                  1000;
+
+        char time_buffer[64];
+        size_t time_len = std::strftime(time_buffer, sizeof(time_buffer),
+                                        "%Y-%m-%dT%H:%M:%S.", std::gmtime(&time));
+        int ms_len = std::snprintf(time_buffer + time_len, sizeof(time_buffer) - time_len,
+                                   "%03dZ", static_cast<int>(ms.count()));
+
+        buffer.insert(buffer.end(), time_buffer, time_buffer + time_len + ms_len);
+    }
+
+    template <typename T>
+    void appendNumber(std::vector<char> &buffer, T value)
+    {
+        char number[32];
+        auto [end, ec] = std::to_chars(number, number + sizeof(number), value);
+        buffer.insert(buffer.end(), number, end);
+    }
+
+    void appendLiteral(std::vector<char> &buffer, std::string_view literal)
+    {
+        buffer.insert(buffer.end(), literal.begin(), literal.end());
+    }
+
+    void appendJsonString(std::vector<char> &buffer, std::string_view str)
+    {
+        buffer.push_back('"');
+        blitz_escape::appendJsonEscaped(buffer, str);
+        buffer.push_back('"');
+    }
+
+    // append a field value as JSON or as a logfmt value
+    void appendFieldValue(std::vector<char> &buffer, const blitz_binary::ArgView &arg, bool json)
+    {
+        std::visit([&](const auto &value)
+                   {
+                       using T = std::decay_t<decltype(value)>;
+
+                       if constexpr (std::same_as<T, bool>)
+                           appendLiteral(buffer, value ? "true" : "false");
+                       else if constexpr (std::same_as<T, char>)
+                           json ? appendJsonString(buffer, std::string_view(&value, 1))
+                                : blitz_escape::appendLogfmtValue(buffer, std::string_view(&value, 1));
+                       else if constexpr (std::same_as<T, std::string_view>)
+                           json ? appendJsonString(buffer, value)
+                                : blitz_escape::appendLogfmtValue(buffer, value);
+                       else if constexpr (std::floating_point<T>)
+                       {
+                           if (json && !std::isfinite(value))
+                               appendLiteral(buffer, "null"); // JSON has no NaN/Infinity
+                           else
+                               appendNumber(buffer, value);
+                       }
+                       else
+                           appendNumber(buffer, value); },
+                   arg);
+    }
+}
+
+void Logger::appendFields(std::string_view fields, bool json, std::vector<char> &buffer)
+{
+    bool isKey = true;
+    blitz_binary::forEachArg(fields, [&](const blitz_binary::ArgView &arg)
+                             {
+                                 if (isKey)
+                                 {
+                                     auto key = std::get<std::string_view>(arg);
+                                     if (json)
+                                     {
+                                         buffer.push_back(',');
+                                         appendJsonString(buffer, key);
+                                         buffer.push_back(':');
+                                     }
+                                     else
+                                     {
+                                         buffer.push_back(' ');
+                                         buffer.insert(buffer.end(), key.begin(), key.end());
+                                         buffer.push_back('=');
+                                     }
+                                 }
+                                 else
+                                 {
+                                     appendFieldValue(buffer, arg, json);
+                                 }
+                                 isKey = !isKey; });
+}
+
+void Logger::formatJsonRecord(const Config &config, const RecordView &msg, std::vector<char> &buffer)
+{
+    const size_t original_size = buffer.size();
+    buffer.reserve(original_size + 192 + msg.message.size() + msg.module.size() + msg.file.size() + msg.fields.size() * 2);
+
+    appendLiteral(buffer, "{\"level\":\"");
+    appendLiteral(buffer, LEVEL_STRINGS[static_cast<size_t>(msg.level)]);
+    buffer.push_back('"');
+
+    if (config.showTimestamp)
+    {
+        appendLiteral(buffer, ",\"ts\":\"");
+        appendIsoTimestamp(buffer, msg.timestamp);
+        buffer.push_back('"');
+    }
+    if (config.showThreadId)
+    {
+        appendLiteral(buffer, ",\"thread\":");
+        appendNumber(buffer, msg.threadHash);
+    }
+    if (config.showModuleName && !msg.module.empty())
+    {
+        appendLiteral(buffer, ",\"module\":");
+        appendJsonString(buffer, msg.module);
+    }
+    if (config.showSourceLocation)
+    {
+        std::string_view file(msg.file);
+        if (!config.showFullPath)
+        {
+            if (auto pos = file.find_last_of("/\\"); pos != std::string_view::npos)
+                file = file.substr(pos + 1);
+        }
+        appendLiteral(buffer, ",\"file\":");
+        appendJsonString(buffer, file);
+        appendLiteral(buffer, ",\"line\":");
+        appendNumber(buffer, msg.line);
+    }
+
+    appendLiteral(buffer, ",\"msg\":");
+    appendJsonString(buffer, msg.message);
+
+    if (!msg.fields.empty())
+    {
+        try
+        {
+            appendFields(msg.fields, true, buffer);
+        }
+        catch (...)
+        {
+            buffer.resize(original_size);
+            throw;
+        }
+    }
+    buffer.push_back('}');
+}
+
+void Logger::formatLogfmtRecord(const Config &config, const RecordView &msg, std::vector<char> &buffer)
+{
+    const size_t original_size = buffer.size();
+    buffer.reserve(original_size + 160 + msg.message.size() + msg.module.size() + msg.file.size() + msg.fields.size() * 2);
+
+    if (config.showTimestamp)
+    {
+        appendLiteral(buffer, "ts=");
+        appendIsoTimestamp(buffer, msg.timestamp);
+        buffer.push_back(' ');
+    }
+
+    appendLiteral(buffer, "level=");
+    appendLiteral(buffer, LEVEL_STRINGS[static_cast<size_t>(msg.level)]);
+
+    if (config.showThreadId)
+    {
+        appendLiteral(buffer, " thread=");
+        appendNumber(buffer, msg.threadHash);
+    }
+    if (config.showModuleName && !msg.module.empty())
+    {
+        appendLiteral(buffer, " module=");
+        blitz_escape::appendLogfmtValue(buffer, msg.module);
+    }
+    if (config.showSourceLocation)
+    {
+        std::string_view file(msg.file);
+        if (!config.showFullPath)
+        {
+            if (auto pos = file.find_last_of("/\\"); pos != std::string_view::npos)
+                file = file.substr(pos + 1);
+        }
+        appendLiteral(buffer, " source=");
+        blitz_escape::appendLogfmtValue(buffer, std::format("{}:{}", file, msg.line));
+    }
+
+    appendLiteral(buffer, " msg=");
+    blitz_escape::appendLogfmtValue(buffer, msg.message);
+
+    if (!msg.fields.empty())
+    {
+        try
+        {
+            appendFields(msg.fields, false, buffer);
+        }
+        catch (...)
+        {
+            buffer.resize(original_size);
+            throw;
+        }
+    }
+}
+
+void Logger::rotateLogFileIfNeeded()
+{
+    if (!config.fileOutput)
+        return;
+
+    bool due = config.rotationPolicy != RotationPolicy::TIME && currentFileSize >= config.maxFileSize;
+
+    if (rotationRequested.load(std::memory_order_relaxed) && rotationRequested.exchange(false))
+    {
+        due = true;
+    }
+
+    if (config.rotationPolicy != RotationPolicy::SIZE)
+    {
+        auto now = std::chrono::system_clock::now();
+        if (now >= nextRotationTime)
+        {
+            // an empty file simply carries over into the next period
+            if (currentFileSize == 0 && pendingOutput.raw.empty())
+                scheduleRotation(now);
+            else
+                due = true;
+        }
+    }
+
+    if (due)
+    {
+        rotateLogFile(std::chrono::system_clock::now());
+    }
+}
+
+void Logger::rotateLogFile(std::chrono::system_clock::time_point now)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // the finished file has to hold everything written so far
+    flushPendingOutput();
+    const bool syncRetired = unsyncedWrites && syncEnabled();
+
+    // swap to a fresh staging file, renaming, closing and retention happen on the maintenance thread
+    MaintenanceJob job;
+    job.activePath = logFilePath();
+
+    // usually the maintenance thread has the next file ready, making this a plain descriptor swap
+    int fd = -1;
+    if (PreparedFile *prepared = preparedFile.exchange(nullptr, std::memory_order_acquire))
+    {
+        if (prepared->activePath == job.activePath)
+        {
+            fd = prepared->fd;
+            job.stagingPath = std::move(prepared->path);
+            delete prepared;
+        }
+        else
+        {
+            discardPreparedFile(prepared); // prepared before a configure() changed the file name
+        }
+    }
+
+    if (fd < 0)
+    {
+        job.stagingPath = nextStagingPath(job.activePath);
+        fd = openLogFile(job.stagingPath);
+        if (fd < 0)
+            return; // keep writing to the current file, retried after the next batch
+    }
+
+    job.retiredFd = std::exchange(logFd, fd);
+    job.retiredBytes = currentFileSize;
+    job.openedAt = currentFileOpenedAt;
+    job.codec = liveCompression() ? nullptr : config.compressionCodec; // a live compressed file is already done
+    job.retention = retentionSettings();
+    job.preallocateBytes = config.preallocateFiles ? config.maxFileSize : 0;
+    job.syncRetired = syncRetired;
+    job.metricsFile = config.metricsFile;
+    job.metricsInterval = config.metricsInterval;
+
+    currentFileSize = 0;
+    unsyncedWrites = false;
+    currentFileOpenedAt = now;
+    scheduleRotation(now);
+    binaryWriter.reset();
+
+    enqueueMaintenance(std::move(job));
+    counters.rotationNs.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+}
+
+void Logger::scheduleRotation(std::chrono::system_clock::time_point now)
+{
+    if (config.rotationPolicy == RotationPolicy::SIZE || config.rotationInterval.count() <= 0)
+    {
+        nextRotationTime = std::chrono::system_clock::time_point::max();
+        return;
+    }
+
+    // align to the local clock so hourly files start on the hour and daily files at midnight
+    auto time = std::chrono::system_clock::to_time_t(now);
+    std::tm local{};
+    localtime_r(&time, &local);
+
+    const int64_t offset = local.tm_gmtoff;
+    const int64_t interval = config.rotationInterval.count();
+    const int64_t next = ((static_cast<int64_t>(time) + offset) / interval + 1) * interval - offset;
+    nextRotationTime = std::chrono::system_clock::from_time_t(static_cast<time_t>(next));
+}
+
+Logger::RetentionSettings Logger::retentionSettings() const
+{
+    RetentionSettings retention;
+    retention.logDir = config.logDir;
+    retention.filePrefix = config.filePrefix;
+    retention.extension = activeFileExtension();
+    if (config.compressionCodec && !liveCompression())
+    {
+        retention.compressedExtension = config.compressionCodec->extension();
+    }
+    retention.maxFiles = config.maxFiles;
+    retention.maxTotalBytes = config.maxTotalBytes;
+    retention.maxFileAge = config.maxFileAge;
+    return retention;
+}
+
+// unused name for a file started at openedAt, taking the next sequence
+std::string Logger::nextRotatedPath(std::chrono::system_clock::time_point openedAt)
+{
+    const auto &retention = maintenanceWorker.retention;
+
+    auto time = std::chrono::system_clock::to_time_t(openedAt);
+    std::tm local{};
+    localtime_r(&time, &local);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", &local);
+
+    // the sequence keeps names unique and ordered for any number of rotations per second
+    std::string rotatedPath;
+    do
+    {
+        rotatedPath = std::format("{}/{}_{}_{:06}{}", retention.logDir, retention.filePrefix, timestamp,
+                                  maintenanceWorker.nextSequence++, retention.extension);
+    } while (std::filesystem::exists(rotatedPath) ||
+             (!retention.compressedExtension.empty() &&
+              std::filesystem::exists(rotatedPath + retention.compressedExtension)));
+    return rotatedPath;
+}
+
+void Logger::finishRotation(MaintenanceJob &job)
+{
+    // close can block on flush for network file systems, keep it off the logger thread
+    if (job.syncRetired)
+        ::fdatasync(job.retiredFd);
+    closeLogFile(job.retiredFd);
+
+    maintenanceWorker.retention = job.retention;
+    std::string rotatedPath = nextRotatedPath(job.openedAt);
+
+    std::error_code ec;
+    std::filesystem::rename(job.activePath, rotatedPath, ec);
+    if (ec)
+    {
+        std::cerr << std::format("Failed to rotate {}: {}\n", job.activePath, ec.message());
+    }
+    else
+    {
+        maintenanceWorker.rotatedFiles.push_back({rotatedPath, job.retiredBytes, std::chrono::system_clock::now(), false});
+        if (job.codec)
+        {
+            enqueueCompression(rotatedPath, job.codec);
+        }
+    }
+
+    // the logger thread keeps writing through its descriptor while the staging file is renamed
+    std::filesystem::rename(job.stagingPath, job.activePath, ec);
+    if (ec)
+    {
+        std::cerr << std::format("Failed to rename {}: {}\n", job.stagingPath, ec.message());
+    }
+
+    cleanOldLogs();
+}
+
+namespace
+{
+    bool allDigits(std::string_view str) noexcept
+    {
+        return !str.empty() && std::all_of(str.begin(), str.end(), [](char c)
+                                           { return c >= '0' && c <= '9'; });
+    }
+
+    // sequence of a rotated file named <prefix>_YYYYMMDD_HHMMSS_NNNNNN<extension>, given the part
+    // between the prefix and the extension; 0 for other names, like those of earlier versions
+    uint64_t rotationSequence(std::string_view stamp) noexcept
+    {
+        // "YYYYMMDD_HHMMSS_" and at least six digits
+        if (stamp.size() < 22 || stamp[8] != '_' || stamp[15] != '_' ||
+            !allDigits(stamp.substr(0, 8)) || !allDigits(stamp.substr(9, 6)) || !allDigits(stamp.substr(16)))
+            return 0;
+
+        uint64_t sequence = 0;
+        std::string_view digits = stamp.substr(16);
+        auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), sequence);
+        return error == std::errc() && end == digits.data() + digits.size() ? sequence : 0;
+    }
+}
+
+std::string Logger::newStagingTag()
+{
+    return std::format("{:08x}", std::random_device{}());
+}
+
+// <active>.next.<tag>.<n>, opened ahead of a rotation and renamed to the active file by it
+std::string Logger::nextStagingPath(const std::string &activePath)
+{
+    return std::format("{}.next.{}.{}", activePath, stagingTag, ++stagingSequence);
+}
+
+void Logger::scanRotatedFiles()
+{
+    const auto &retention = maintenanceWorker.retention;
+    const std::string namePrefix = retention.filePrefix + "_";
+    const std::string compressedExtension = retention.extension + retention.compressedExtension;
+    const std::string stagingPrefix = retention.filePrefix + retention.extension + ".next.";
+
+    // collect rotated log files, compressed or not
+    std::vector<RotatedFile> logFiles;
+    std::vector<std::filesystem::path> staleStaging;
+    std::vector<std::filesystem::path> partialFiles;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(retention.logDir, ec))
+    {
+        std::string name = entry.path().filename().string();
+
+        // staging files of a process that crashed before it could rename or remove them
+        if (name.starts_with(stagingPrefix))
+        {
+            if (!std::string_view(name).substr(stagingPrefix.size()).starts_with(stagingTag + "."))
+                staleStaging.push_back(entry.path());
+            continue;
+        }
+        if (!name.starts_with(namePrefix))
+            continue;
+
+        // <rotated>.log<codec>.tmp, written by compressFile() until it is renamed
+        if (name.ends_with(".tmp") && name.find(retention.extension + ".") != std::string::npos)
+        {
+            partialFiles.push_back(entry.path());
+            continue;
+        }
+
+        RotatedFile file{entry.path().string(), 0, {}, false};
+        if (!retention.compressedExtension.empty() && name.ends_with(compressedExtension))
+        {
+            file.path.resize(file.path.size() - retention.compressedExtension.size()); // tracked without it
+            file.compressed = true;
+        }
+        else if (!name.ends_with(retention.extension))
+        {
+            continue;
+        }
+
+        file.bytes = entry.file_size(ec);
+        auto modified = entry.last_write_time(ec);
+        if (ec)
+            continue;
+        file.modified = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            std::chrono::file_clock::to_sys(modified));
+
+        // continue numbering after the highest sequence already on disk
+        std::string_view stem = std::string_view(name).substr(0, name.size() - (file.compressed ? compressedExtension : retention.extension).size());
+        if (uint64_t sequence = stem.size() > namePrefix.size() ? rotationSequence(stem.substr(namePrefix.size())) : 0; sequence > 0)
+        {
+            maintenanceWorker.nextSequence = std::max(maintenanceWorker.nextSequence, sequence + 1);
+        }
+
+        logFiles.push_back(std::move(file));
+    }
+
+    // partial output of a compression a crash interrupted, the original is still there and tracked
+    if (!partialFiles.empty())
+    {
+        std::lock_guard<std::mutex> lock(compressionWorker.mutex);
+        const std::string active = std::filesystem::path(compressionWorker.active).filename().string();
+        for (const auto &path : partialFiles)
+        {
+            if (active.empty() || !path.filename().string().starts_with(active))
+                std::filesystem::remove(path, ec);
+        }
+    }
+
+    // a staging file still at size 0 was never written (preallocation keeps the size); one that
+    // was swapped in may hold synced records, so it joins the rotated files instead
+    for (const auto &path : staleStaging)
+    {
+        auto bytes = std::filesystem::file_size(path, ec);
+        if (ec)
+            continue;
+        if (bytes == 0)
+        {
+            std::filesystem::remove(path, ec);
+            continue;
+        }
+        auto modified = std::filesystem::last_write_time(path, ec);
+        if (ec)
+            continue;
+
+        RotatedFile file{{}, bytes, {}, false};
+        file.modified = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            std::chrono::file_clock::to_sys(modified));
+        file.path = nextRotatedPath(file.modified);
+        std::filesystem::rename(path, file.path, ec);
+        if (ec)
+        {
+            std::cerr << std::format("Failed to recover {}: {}\n", path.string(), ec.message());
+            continue;
+        }
+        logFiles.push_back(std::move(file));
+    }
+
+    // sort by modification time (oldest first)
+    std::sort(logFiles.begin(), logFiles.end(),
+              [](const auto &a, const auto &b)
+              {
+                  return a.modified < b.modified;
+              });
+
+    maintenanceWorker.rotatedFiles.assign(std::make_move_iterator(logFiles.begin()),
+                                          std::make_move_iterator(logFiles.end()));
+}
+
+void Logger::cleanOldLogs()
+{
+    auto &rotatedFiles = maintenanceWorker.rotatedFiles;
+    const auto &retention = maintenanceWorker.retention;
+
+    // pick up the sizes of files compressed since the last pass
+    size_t totalBytes = 0;
+    for (auto &file : rotatedFiles)
+    {
+        if (!file.compressed && !retention.compressedExtension.empty())
+        {
+            std::error_code ec;
+            size_t bytes = std::filesystem::file_size(file.path + retention.compressedExtension, ec);
+            if (!ec)
+            {
+                file.bytes = bytes;
+                file.compressed = true;
+            }
+        }
+        totalBytes += file.bytes;
+    }
+
+    // maxFiles includes the active file
+    const size_t keep = retention.maxFiles > 0 ? retention.maxFiles - 1 : 0;
+    const auto now = std::chrono::system_clock::now();
+
+    // remove old files, in whichever form the compression worker left them
+    while (!rotatedFiles.empty() &&
+           (rotatedFiles.size() > keep ||
+            (retention.maxTotalBytes > 0 && totalBytes > retention.maxTotalBytes) ||
+            (retention.maxFileAge.count() > 0 && now - rotatedFiles.front().modified > retention.maxFileAge)))
+    {
+        std::error_code ec;
+        std::filesystem::remove(rotatedFiles.front().path, ec);
+        if (!retention.compressedExtension.empty())
+        {
+            std::filesystem::remove(rotatedFiles.front().path + retention.compressedExtension, ec);
+        }
+        totalBytes -= rotatedFiles.front().bytes;
+        rotatedFiles.pop_front();
+    }
+}
+
+void Logger::enqueueMaintenance(MaintenanceJob job)
+{
+    std::lock_guard<std::mutex> lock(maintenanceWorker.mutex);
+    maintenanceWorker.pending.push_back(std::move(job));
+
+    if (!maintenanceWorker.thread.joinable())
+    {
+        maintenanceWorker.thread = std::thread([this, options = config.maintenanceThreadOptions]()
+                                               {
+            applyThreadOptions(options);
+            runMaintenanceWorker(); });
+    }
+    maintenanceWorker.wakeup.notify_one();
+}
+
+void Logger::runMaintenanceWorker()
+{
+    auto ready = [this]()
+    { return maintenanceWorker.stopping || !maintenanceWorker.pending.empty(); };
+
+    auto nextAgeCheck = std::chrono::steady_clock::now();
+    auto nextMetricsExport = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(maintenanceWorker.mutex);
+    while (true)
+    {
+        // age based retention and the metrics export have to run while nothing rotates, too
+        const auto maxFileAge = maintenanceWorker.retention.maxFileAge;
+        const std::string metricsFile = maintenanceWorker.metricsFile;
+        const bool ageChecks = maxFileAge.count() > 0;
+        const bool metricsExports = !metricsFile.empty() && maintenanceWorker.metricsInterval.count() > 0;
+
+        if (ageChecks || metricsExports)
+        {
+            auto deadline = std::min(ageChecks ? nextAgeCheck : nextMetricsExport,
+                                     metricsExports ? nextMetricsExport : nextAgeCheck);
+            if (!maintenanceWorker.wakeup.wait_until(lock, deadline, ready))
+            {
+                const auto now = std::chrono::steady_clock::now();
+                const auto metricsInterval = maintenanceWorker.metricsInterval;
+                lock.unlock();
+                if (ageChecks && now >= nextAgeCheck)
+                {
+                    cleanOldLogs();
+                    nextAgeCheck = now + std::min<std::chrono::seconds>(maxFileAge, std::chrono::minutes(1));
+                }
+                if (metricsExports && now >= nextMetricsExport)
+                {
+                    exportMetrics(metricsFile);
+                    nextMetricsExport = now + metricsInterval;
+                }
+                lock.lock();
+                continue;
+            }
+        }
+        else
+        {
+            maintenanceWorker.wakeup.wait(lock, ready);
+        }
+
+        if (maintenanceWorker.pending.empty())
+        {
+            // stopping and nothing left to do, leave the final counters behind
+            if (!metricsFile.empty())
+            {
+                lock.unlock();
+                exportMetrics(metricsFile);
+            }
+            return;
+        }
+
+        MaintenanceJob job = std::move(maintenanceWorker.pending.front());
+        maintenanceWorker.pending.pop_front();
+        maintenanceWorker.metricsFile = job.metricsFile;
+        maintenanceWorker.metricsInterval = job.metricsInterval;
+        lock.unlock();
+
+        try
+        {
+            if (job.retiredFd >= 0)
+            {
+                finishRotation(job);
+            }
+            else if (!job.activePath.empty())
+            {
+                // (re)configured, files from earlier runs are picked up once and tracked from then on
+                maintenanceWorker.retention = job.retention;
+                scanRotatedFiles();
+                cleanOldLogs();
+            }
+            if (!job.activePath.empty())
+                prepareNextFile(job);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << std::format("Log maintenance failed: {}\n", e.what());
+        }
+
+        lock.lock();
+    }
+}
+
+void Logger::stopMaintenanceWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(maintenanceWorker.mutex);
+        maintenanceWorker.stopping = true;
+    }
+    maintenanceWorker.wakeup.notify_one();
+
+    // finishes the queued rotations first, they may still queue compressions
+    if (maintenanceWorker.thread.joinable())
+    {
+        maintenanceWorker.thread.join();
+    }
+}
+
+void Logger::prepareNextFile(const MaintenanceJob &job)
+{
+    // the previous one has not been used yet
+    if (preparedFile.load(std::memory_order_relaxed))
+        return;
+
+    auto prepared = std::make_unique<PreparedFile>();
+    prepared->activePath = job.activePath;
+    prepared->path = nextStagingPath(job.activePath);
+    prepared->fd = openLogFile(prepared->path);
+    if (prepared->fd < 0)
+        return; // the logger thread opens one itself
+
+#ifdef __linux__
+    // reserve the blocks without changing the file size, so appends never wait for allocation,
+    // best effort as not every file system supports it
+    if (job.preallocateBytes > 0)
+    {
+        (void)::fallocate(prepared->fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(job.preallocateBytes));
+    }
+#endif
+
+    preparedFile.store(prepared.release(), std::memory_order_release);
+}
+
+void Logger::discardPreparedFile(PreparedFile *file)
+{
+    if (!file)
+        return;
+
+    ::close(file->fd);
+    ::unlink(file->path.c_str());
+    delete file;
+}
+
+int Logger::openLogFile(const std::string &path)
+{
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
 
-    if (config.consoleOutput && !consoleBuffer.empty())
+void Logger::closeLogFile(int fd)
+{
+    // give back preallocated space beyond what was written
+    struct stat status{};
+    if (::fstat(fd, &status) == 0)
     {
-        std::cout.write(consoleBuffer.data(), consoleBuffer.size());
+        (void)::ftruncate(fd, status.st_size);
     }
+    ::close(fd);
 }
 
-void Logger::drainAllBuffers(
-    std::vector<LogMessage> &batchBuffer,
-    std::vector<char> &fileBuffer,
-    std::vector<char> &consoleBuffer)
+void Logger::writeToFd(const char *data, size_t size)
 {
-    auto buffers = bufferRegistry.getAllBuffers();
-    for (auto &buffer : buffers)
+    const auto start = config.latencyHistograms ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    while (size > 0)
     {
-        LogMessage msg;
-        while (buffer->pop(msg))
+        ssize_t written = ::write(logFd, data, size);
+        if (written < 0)
         {
-            batchBuffer.push_back(std::move(msg));
-            if (batchBuffer.size() >= 4096)
-            {
-                processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
-            }
+            if (errno == EINTR)
+                continue;
+
+            // disk full or similar, drop the rest of this batch
+            counters.writeErrors.fetch_add(1, std::memory_order_relaxed);
+            counters.bytesDropped.fetch_add(size, std::memory_order_relaxed);
+            return;
         }
+        data += written;
+        size -= static_cast<size_t>(written);
+        unsyncedWrites = true;
+        counters.fileBytes.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
     }
-    processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
 
-    // final flush to ensure all data is written to disk
-    if (config.fileOutput && logFile.is_open())
+    if (config.latencyHistograms)
     {
-        logFile.flush();
+        stageHistograms.write.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
     }
 }
 
-void Logger::updateThreadStats()
+void Logger::encodeBinaryMessage(const LogMessage &msg, std::vector<char> &buffer)
 {
-    auto threadId = std::this_thread::get_id();
+    using blitz_binary::Tag;
+    auto &writer = binaryWriter;
 
-    std::lock_guard<std::mutex> lock(statsMapMutex);
-    auto [it, inserted] = threadStatsMap.try_emplace(threadId, std::make_shared<ThreadStats>());
+    const int64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    msg.timestamp.time_since_epoch())
+                                    .count();
 
-    if (inserted)
+    // every file starts with a header that resets the reader's dictionaries
+    if (writer.headerPending)
     {
-        it->second->threadId = threadId;
+        buffer.insert(buffer.end(), blitz_binary::MAGIC.begin(), blitz_binary::MAGIC.end());
+        buffer.push_back(static_cast<char>(blitz_binary::VERSION));
+        blitz_binary::putVarint(buffer, static_cast<uint64_t>(timestampNs));
+        writer.lastTimestampNs = timestampNs;
+        writer.headerPending = false;
     }
-    it->second->messagesProduced.fetch_add(1, std::memory_order_relaxed);
-}
-void Logger::formatLogMessage(const LogMessage &msg, std::vector<char> &buffer) noexcept
-{
-    // calculate total required size to avoid reallocation
-    size_t required_size = 256 + msg.message.size(); // base size
-
-    if (config.showTimestamp)
-        required_size += 32; // timestamp needs about 32 bytes
-    if (config.showThreadId)
-        required_size += 32; // thread id needs about 32 bytes
-    if (config.showModuleName && !msg.context.module.empty())
-        required_size += msg.context.module.size() + 3; // module name + "[] "
-    if (config.showSourceLocation)
-        required_size += msg.context.file.size() + 10; // file name + line number + "[] "
 
-    // reserve space once
-    size_t original_size = buffer.size();
-    buffer.reserve(original_size + required_size);
+    // text messages are stored as a single string argument of "{}"
+    std::string_view format = msg.format.empty() ? blitz_binary::PREFORMATTED : msg.format;
 
-    // use back_inserter to avoid repeated insert calls
-    auto inserter = std::back_inserter(buffer);
+    BinaryWriter::CallSiteKey key{format, msg.context.file, msg.context.line, msg.level};
+    auto site = writer.callSites.find(key);
+    if (site == writer.callSites.end())
+    {
+        key.file = writer.fileNames.emplace_back(msg.context.file);
+        site = writer.callSites.emplace(key, static_cast<uint32_t>(writer.callSites.size())).first;
+
+        buffer.push_back(static_cast<char>(Tag::CALL_SITE));
+        blitz_binary::putVarint(buffer, site->second);
+        buffer.push_back(static_cast<char>(msg.level));
+        blitz_binary::putVarint(buffer, static_cast<uint64_t>(msg.context.line));
+        blitz_binary::putString(buffer, msg.context.file);
+        blitz_binary::putString(buffer, msg.context.function);
+        blitz_binary::putString(buffer, format);
+    }
 
-    // format timestamp
-    if (config.showTimestamp) [[likely]]
+    auto module = writer.modules.find(msg.context.module);
+    if (module == writer.modules.end())
     {
-        auto time = std::chrono::system_clock::to_time_t(msg.timestamp);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                      msg.timestamp.time_since_epoch()) %
-                  1000;
+        module = writer.modules.emplace(msg.context.module, static_cast<uint32_t>(writer.modules.size())).first;
 
-        char time_buffer[64];
-        size_t time_len = std::strftime(time_buffer, sizeof(time_buffer),
-                                        "[%Y-%m-%d %H:%M:%S.", std::localtime(&time));
+        buffer.push_back(static_cast<char>(Tag::MODULE));
+        blitz_binary::putVarint(buffer, module->second);
+        blitz_binary::putString(buffer, msg.context.module);
+    }
 
-        // format milliseconds and closing bracket
-        int ms_len = std::snprintf(time_buffer + time_len, sizeof(time_buffer) - time_len,
-                                   "%03d] ", static_cast<int>(ms.count()));
+    auto thread = writer.threads.find(msg.context.threadId);
+    if (thread == writer.threads.end())
+    {
+        thread = writer.threads.emplace(msg.context.threadId, static_cast<uint32_t>(writer.threads.size())).first;
 
-        std::copy_n(time_buffer, time_len + ms_len, inserter);
+        buffer.push_back(static_cast<char>(Tag::THREAD));
+        blitz_binary::putVarint(buffer, thread->second);
+        blitz_binary::putVarint(buffer, std::hash<std::thread::id>{}(msg.context.threadId));
     }
 
-    // format log level
-    const auto &level_str = LEVEL_STRINGS[static_cast<size_t>(msg.level)];
-    *inserter++ = '[';
-    std::copy(level_str.begin(), level_str.end(), inserter);
-    *inserter++ = ']';
-    *inserter++ = ' ';
+    buffer.push_back(static_cast<char>(Tag::MESSAGE));
+    blitz_binary::putVarint(buffer, site->second);
+    blitz_binary::putVarint(buffer, module->second);
+    blitz_binary::putVarint(buffer, thread->second);
+    blitz_binary::putVarint(buffer, blitz_binary::zigzag(timestampNs - writer.lastTimestampNs));
+    writer.lastTimestampNs = timestampNs;
 
-    // format thread id
-    if (config.showThreadId) [[likely]]
+    if (msg.format.empty())
     {
-        char thread_buffer[32];
-        int thread_len = std::snprintf(thread_buffer, sizeof(thread_buffer),
-                                       "[T-%zu] ",
-                                       std::hash<std::thread::id>{}(msg.context.threadId));
-        std::copy_n(thread_buffer, thread_len, inserter);
+        writer.scratch.clear();
+        blitz_binary::encodeArg(writer.scratch, std::string_view(msg.message));
+        blitz_binary::putString(buffer, writer.scratch);
     }
-
-    // format module name
-    if (config.showModuleName && !msg.context.module.empty()) [[likely]]
+    else
     {
-        *inserter++ = '[';
-        std::copy(msg.context.module.begin(), msg.context.module.end(), inserter);
-        *inserter++ = ']';
-        *inserter++ = ' ';
+        blitz_binary::putString(buffer, msg.message);
     }
+    blitz_binary::putString(buffer, msg.fields);
+}
 
-    // format source location
-    if (config.showSourceLocation) [[likely]]
+std::string Logger::logFileExtension() const
+{
+    return config.binaryOutput ? ".blz" : ".log";
+}
+
+std::string Logger::activeFileExtension() const
+{
+    if (liveCompression())
+        return logFileExtension() + std::string(config.compressionCodec->extension());
+    return logFileExtension();
+}
+
+std::string Logger::logFilePath() const
+{
+    return std::format("{}/{}{}", config.logDir, config.filePrefix, activeFileExtension());
+}
+
+bool Logger::liveCompression() const
+{
+    return config.compressLiveFile && config.compressionCodec;
+}
+
+void Logger::writeToLogFile(const std::vector<char> &data)
+{
+    if (!liveCompression() && config.flushIntervalMs == 0)
     {
-        std::string_view file(msg.context.file);
-        if (!config.showFullPath) [[likely]]
-        {
-            if (auto pos = file.find_last_of("/\\"); pos != std::string_view::npos)
-                file = file.substr(pos + 1);
-        }
+        writeToFd(data.data(), data.size());
+        currentFileSize += data.size();
+        return;
+    }
 
-        *inserter++ = '[';
-        std::copy(file.begin(), file.end(), inserter);
+    auto now = std::chrono::steady_clock::now();
+    if (pendingOutput.raw.empty())
+        pendingOutput.firstByte = now;
+    pendingOutput.raw.insert(pendingOutput.raw.end(), data.begin(), data.end());
 
-        char line_buffer[16];
-        int line_len = std::snprintf(line_buffer, sizeof(line_buffer),
-                                     ":%d] ", msg.context.line);
-        std::copy_n(line_buffer, line_len, inserter);
+    if (pendingOutputDue(now))
+    {
+        flushPendingOutput();
     }
+}
+
+bool Logger::pendingOutputDue(std::chrono::steady_clock::time_point now) const
+{
+    if (pendingOutput.raw.empty())
+        return false;
 
-    // append message content
-    std::copy(msg.message.begin(), msg.message.end(), inserter);
+    const size_t limit = liveCompression() ? PendingOutput::FRAME_SIZE : config.flushBytes;
+    const std::chrono::steady_clock::duration delay =
+        config.flushIntervalMs > 0 ? std::chrono::milliseconds(config.flushIntervalMs) : PendingOutput::MAX_DELAY;
+    return pendingOutput.raw.size() >= limit || now - pendingOutput.firstByte >= delay;
 }
 
-void Logger::rotateLogFileIfNeeded()
+void Logger::flushPendingOutput()
 {
-    if (!config.fileOutput || currentFileSize < config.maxFileSize)
+    if (pendingOutput.raw.empty())
         return;
 
-    logFile.close();
+    if (!liveCompression())
+    {
+        writeToFd(pendingOutput.raw.data(), pendingOutput.raw.size());
+        currentFileSize += pendingOutput.raw.size();
+        pendingOutput.raw.clear();
+        return;
+    }
 
-    // generate new filename with timestamp
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    char timestamp[32];
-    std::strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S",
-                  std::localtime(&time));
+    // currentFileSize counts compressed bytes, so maxFileSize limits disk usage
+    pendingOutput.compressed.clear();
+    config.compressionCodec->compressFrame(std::string_view(pendingOutput.raw.data(), pendingOutput.raw.size()),
+                                           pendingOutput.compressed);
+    writeToFd(pendingOutput.compressed.data(), pendingOutput.compressed.size());
+    currentFileSize += pendingOutput.compressed.size();
+    pendingOutput.raw.clear();
+}
 
-    std::string oldFile = std::format("{}/{}.log", config.logDir, config.filePrefix);
-    std::string newFile = std::format("{}/{}_{}.log",
-                                      config.logDir, config.filePrefix, timestamp);
+bool Logger::syncEnabled() const
+{
+    return config.syncIntervalMs > 0 || config.syncOnError;
+}
 
-    // rename current log file
-    if (std::filesystem::exists(oldFile))
+// runs on the logger thread, producers keep filling their buffers meanwhile
+void Logger::syncLogFile(bool urgent)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (urgent)
     {
-        std::filesystem::rename(oldFile, newFile);
+        flushPendingOutput(); // held back output is part of what has to be durable
+    }
+    else if (now - lastSync < std::chrono::milliseconds(config.syncIntervalMs))
+    {
+        return;
     }
 
-    // open new log file
-    logFile.open(oldFile, std::ios::app);
-    currentFileSize = 0;
-
-    // clean old logs
-    cleanOldLogs();
+    if (unsyncedWrites)
+    {
+        counters.fileSyncs.fetch_add(1, std::memory_order_relaxed);
+        if (::fdatasync(logFd) == 0)
+            unsyncedWrites = false;
+    }
+    lastSync = now;
 }
 
-void Logger::cleanOldLogs()
+void Logger::enqueueCompression(std::string path, std::shared_ptr<const blitz_compress::Codec> codec)
 {
-    std::vector<std::filesystem::path> logFiles;
+    std::lock_guard<std::mutex> lock(compressionWorker.mutex);
+    compressionWorker.pending.emplace_back(std::move(path), std::move(codec));
+
+    if (!compressionWorker.thread.joinable())
+    {
+        compressionWorker.thread = std::thread([this, options = config.compressionThreadOptions]()
+                                               {
+            applyThreadOptions(options); // lowest priority by default, compression must not compete with producers
+            runCompressionWorker(); });
+    }
+    compressionWorker.wakeup.notify_one();
+}
 
-    // collect all log files
-    for (const auto &entry : std::filesystem::directory_iterator(config.logDir))
+void Logger::runCompressionWorker()
+{
+    std::unique_lock<std::mutex> lock(compressionWorker.mutex);
+    while (true)
     {
-        if (entry.path().extension() == ".log" &&
-            entry.path().stem().string().starts_with(config.filePrefix))
+        compressionWorker.wakeup.wait(lock, [this]()
+                                      { return compressionWorker.stopping || !compressionWorker.pending.empty(); });
+        if (compressionWorker.pending.empty())
+            return; // stopping and nothing left to compress
+
+        auto [path, codec] = std::move(compressionWorker.pending.front());
+        compressionWorker.pending.pop_front();
+        compressionWorker.active = path;
+        lock.unlock();
+
+        try
+        {
+            blitz_compress::compressFile(*codec, path);
+        }
+        catch (const std::exception &e)
         {
-            logFiles.push_back(entry.path());
+            // retention may have removed the file meanwhile, anything else leaves it uncompressed
+            if (std::filesystem::exists(path))
+            {
+                std::cerr << std::format("Failed to compress {}: {}\n", path, e.what());
+            }
         }
+
+        lock.lock();
+        compressionWorker.active.clear();
     }
+}
 
-    // sort by modification time (newest first)
-    std::sort(logFiles.begin(), logFiles.end(),
-              [](const auto &a, const auto &b)
-              {
-                  return std::filesystem::last_write_time(a) >
-                         std::filesystem::last_write_time(b);
-              });
+void Logger::stopCompressionWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(compressionWorker.mutex);
+        compressionWorker.stopping = true;
+    }
+    compressionWorker.wakeup.notify_one();
 
-    // remove old files
-    while (logFiles.size() > config.maxFiles)
+    // finishes the queued files first
+    if (compressionWorker.thread.joinable())
     {
-        std::filesystem::remove(logFiles.back());
-        logFiles.pop_back();
+        compressionWorker.thread.join();
     }
 }
 
@@ -372,26 +1906,47 @@ void Logger::initialize(const Config &cfg)
                    {
         instance = std::make_unique<Logger>();
         instance->configure(cfg); // configure logger
+        instance->started = true;
+
+        if ((cfg.preallocatedBuffers > 0 || cfg.pooledBuffers > 0) && !cfg.synchronous)
+        {
+            instance->bufferArena = std::make_shared<BufferArena>(
+                cfg.preallocatedBuffers, ThreadLocalBuffer::roundCapacity(cfg.bufferCapacity), cfg.pooledBuffers,
+                cfg.numaLocalBuffers);
+        }
         
-        instance->loggerThread = std::thread([instance = instance.get()]() {
-            instance->processLogs();
-        });
+        if (!cfg.synchronous)
+        {
+            instance->loggerThread = std::thread([instance = instance.get()]() {
+                instance->processLogs();
+            });
+        }
         
-        instance->log(std::source_location::current(), Level::INFO, "Logger initialized with thread-local buffers"); });
+        instance->log(std::source_location::current(), Level::INFO, "Logger initialized {}",
+                      cfg.synchronous ? "in synchronous mode" : "with thread-local buffers"); });
 }
 
 void Logger::configure(const Config &cfg)
 {
     std::unique_lock lock(configMutex);
+    std::lock_guard<std::mutex> sinkLock(syncMutex); // writers in synchronous mode
 
     // close the current log file if open
-    if (logFile.is_open())
+    if (logFd >= 0)
     {
-        logFile.close();
+        closeLogFile(logFd);
+        logFd = -1;
     }
+    discardPreparedFile(preparedFile.exchange(nullptr)); // named after the old configuration
 
-    // update the configuration
+    // restart the metrics server only when its endpoint changes, scrapers keep their connection target
+    const bool restartMetricsServer =
+        cfg.metricsEndpoint != config.metricsEndpoint || (metricsServer == nullptr) != cfg.metricsEndpoint.empty();
+
+    // update the configuration, the logger thread is started (or not) once by initialize()
+    const bool synchronous = started ? config.synchronous : cfg.synchronous;
     config = cfg;
+    config.synchronous = synchronous;
 
     // reopen the log file with the new configuration
     if (config.fileOutput)
@@ -401,18 +1956,80 @@ void Logger::configure(const Config &cfg)
             std::filesystem::create_directories(config.logDir);
         }
 
-        std::string filename = std::format("{}/{}.log",
-                                           config.logDir, config.filePrefix);
-        logFile.open(filename, std::ios::app);
-        if (!logFile)
+        std::string filename = logFilePath();
+        logFd = openLogFile(filename);
+        binaryWriter.reset();
+        if (logFd < 0)
         {
             throw std::runtime_error(std::format("Failed to open log file: {}", filename));
         }
 
         currentFileSize = std::filesystem::file_size(filename);
+        currentFileOpenedAt = std::chrono::system_clock::now();
+        scheduleRotation(currentFileOpenedAt);
+    }
+
+    // pick up rotated files of earlier runs for retention, and (re)start the metrics export
+    if (config.fileOutput || !config.metricsFile.empty())
+    {
+        MaintenanceJob rescan;
+        if (config.fileOutput)
+        {
+            rescan.activePath = logFilePath();
+            rescan.retention = retentionSettings();
+            rescan.preallocateBytes = config.preallocateFiles ? config.maxFileSize : 0;
+        }
+        rescan.metricsFile = config.metricsFile;
+        rescan.metricsInterval = config.metricsInterval;
+        enqueueMaintenance(std::move(rescan));
+    }
+
+    if (restartMetricsServer)
+    {
+        metricsServer.reset();
+        // metrics are optional, a logger that failed to start its logger thread over them would never drain
+        if (!config.metricsEndpoint.empty())
+        {
+            try
+            {
+                metricsServer = std::make_unique<blitz_http::MetricsServer>(
+                    config.metricsEndpoint, [this]()
+                    { return metrics().toPrometheus(); },
+                    [options = config.metricsThreadOptions]()
+                    { applyThreadOptions(options); });
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << std::format("Metrics endpoint disabled: {}\n", e.what());
+            }
+        }
     }
 }
 
+bool Logger::flush(std::chrono::milliseconds timeout, bool sync)
+{
+    if (config.synchronous)
+    {
+        flushSynchronous(sync, false); // every message is written by the time its log call returns
+        return true;
+    }
+
+    std::unique_lock lock(flushBarrier.mutex);
+    const uint64_t generation = flushBarrier.requested.load(std::memory_order_relaxed) + 1;
+    if (sync)
+        flushBarrier.syncUpTo = generation;
+    flushBarrier.requested.store(generation, std::memory_order_release);
+    flushBarrier.wakeup.notify_one();
+
+    return flushBarrier.done.wait_for(lock, timeout, [&]
+                                      { return flushBarrier.completed >= generation; });
+}
+
+void Logger::rotate()
+{
+    rotationRequested.store(true, std::memory_order_relaxed);
+}
+
 void Logger::setLogLevel(Level level)
 {
     std::unique_lock lock(configMutex);
@@ -462,6 +2079,226 @@ void Logger::printStats() const
     std::cout << std::format("{:>15}{:>15}\n",
                              "Total",
                              totalProduced);
+
+    if (!config.latencyHistograms)
+        return;
+
+    // aggregated latency per stage
+    blitz_histogram::Snapshot producer;
+    {
+        std::lock_guard<std::mutex> lock(statsMapMutex);
+        for (const auto &[threadId, stats] : threadStatsMap)
+            producer.merge(stats->producerLatency.snapshot());
+    }
+
+    std::cout << "\n" << std::format("{:>15}{:>12}{:>12}{:>12}{:>12}{:>12}\n",
+                                     "Stage", "Count", "P50 (μs)", "P99 (μs)", "P99.9 (μs)", "Max (μs)");
+    std::cout << std::string(75, '-') << "\n";
+    auto printStage = [](std::string_view stage, const blitz_histogram::Snapshot &snapshot)
+    {
+        std::cout << std::format("{:>15}{:>12}{:>12.2f}{:>12.2f}{:>12.2f}{:>12.2f}\n",
+                                 stage, snapshot.count,
+                                 snapshot.percentile(0.5) / 1000.0,
+                                 snapshot.percentile(0.99) / 1000.0,
+                                 snapshot.percentile(0.999) / 1000.0,
+                                 snapshot.max / 1000.0);
+    };
+    printStage("Producer", producer);
+    printStage("Queue", stageHistograms.queue.snapshot());
+    printStage("Format/batch", stageHistograms.format.snapshot());
+    printStage("Write", stageHistograms.write.snapshot());
+    printStage("End to end", stageHistograms.endToEnd.snapshot());
+}
+
+Logger::Metrics Logger::metrics() const
+{
+    Metrics result;
+
+    std::unique_lock registryLock(bufferRegistry.registryMutex);
+    result.blockedPushes = counters.retiredBlockedPushes.load(std::memory_order_relaxed);
+    result.yieldSpins = counters.retiredYieldSpins.load(std::memory_order_relaxed);
+    for (const auto &buffer : bufferRegistry.buffers)
+    {
+        BufferMetrics &metrics = result.buffers.emplace_back(BufferMetrics{
+            std::hash<std::thread::id>{}(buffer->ownerThreadId),
+            buffer->capacity - 1,
+            buffer->size(),
+            buffer->highWaterMark.load(std::memory_order_relaxed),
+            buffer->blockedPushes.load(std::memory_order_relaxed),
+            buffer->yieldSpins.load(std::memory_order_relaxed),
+            buffer->numaNode});
+        result.blockedPushes += metrics.blockedPushes;
+        result.yieldSpins += metrics.yieldSpins;
+    }
+    registryLock.unlock();
+
+    {
+        std::lock_guard<std::mutex> lock(statsMapMutex);
+        for (const auto &[threadId, stats] : threadStatsMap)
+            result.messagesProduced += stats->messagesProduced.load(std::memory_order_relaxed);
+    }
+
+    result.messagesConsumed = counters.messagesConsumed.load(std::memory_order_relaxed);
+    result.messagesDropped = counters.messagesDropped.load(std::memory_order_relaxed);
+    result.fileBytes = counters.fileBytes.load(std::memory_order_relaxed);
+    result.consoleBytes = counters.consoleBytes.load(std::memory_order_relaxed);
+    result.writeErrors = counters.writeErrors.load(std::memory_order_relaxed);
+    result.fileSyncs = counters.fileSyncs.load(std::memory_order_relaxed);
+    result.bytesDropped = counters.bytesDropped.load(std::memory_order_relaxed);
+    result.bufferGrowths = counters.bufferGrowths.load(std::memory_order_relaxed);
+    result.buffersRetired = counters.buffersRetired.load(std::memory_order_relaxed);
+    result.buffersReused = bufferArena ? bufferArena->reused.load(std::memory_order_relaxed) : 0;
+    result.batchSizes = counters.batchSizes.snapshot();
+    result.rotationNs = counters.rotationNs.snapshot();
+    result.endToEndNs = stageHistograms.endToEnd.snapshot();
+    return result;
+}
+
+std::string Logger::Metrics::toPrometheus() const
+{
+    std::string out;
+    auto metric = [&out](std::string_view name, std::string_view type, std::string_view help)
+    {
+        out += std::format("# HELP blitz_{} {}\n# TYPE blitz_{} {}\n", name, help, name, type);
+    };
+    auto counter = [&](std::string_view name, std::string_view help, uint64_t value)
+    {
+        metric(name, "counter", help);
+        out += std::format("blitz_{} {}\n", name, value);
+    };
+    auto summary = [&](std::string_view name, std::string_view help, const blitz_histogram::Snapshot &snapshot, double scale)
+    {
+        metric(name, "summary", help);
+        for (double quantile : {0.5, 0.9, 0.99, 0.999})
+            out += std::format("blitz_{}{{quantile=\"{}\"}} {}\n", name, quantile, snapshot.percentile(quantile) * scale);
+        out += std::format("blitz_{}_sum {}\nblitz_{}_count {}\n", name, snapshot.sum * scale, name, snapshot.count);
+    };
+    auto perBuffer = [&](std::string_view name, std::string_view type, std::string_view help, auto field)
+    {
+        metric(name, type, help);
+        for (const auto &buffer : buffers)
+            out += std::format("blitz_{}{{thread=\"{:x}\"}} {}\n", name, buffer.threadHash, buffer.*field);
+    };
+
+    counter("messages_produced_total", "Messages logged.", messagesProduced);
+    counter("messages_consumed_total", "Messages taken from the buffers by the logger thread.", messagesConsumed);
+    counter("messages_dropped_total", "Log calls that failed.", messagesDropped);
+    metric("consumer_lag_messages", "gauge", "Messages logged but not yet taken by the logger thread.");
+    out += std::format("blitz_consumer_lag_messages {}\n", consumerLag());
+    counter("blocked_pushes_total", "Log calls that found their buffer full.", blockedPushes);
+    counter("yield_spins_total", "Yields of producers waiting for buffer space.", yieldSpins);
+    counter("file_bytes_total", "Bytes written to log files.", fileBytes);
+    counter("console_bytes_total", "Bytes written to the console.", consoleBytes);
+    counter("write_errors_total", "Failed log file writes.", writeErrors);
+    counter("file_syncs_total", "fdatasync calls on the active log file.", fileSyncs);
+    counter("bytes_dropped_total", "Bytes lost to failed log file writes.", bytesDropped);
+    counter("buffer_growths_total", "Larger rings handed to threads that kept finding theirs full.", bufferGrowths);
+    counter("buffers_retired_total", "Rings of exited threads drained and released.", buffersRetired);
+    counter("buffers_reused_total", "Rings handed to new threads from the pool instead of allocated.", buffersReused);
+    summary("batch_size", "Messages per logger thread batch.", batchSizes, 1.0);
+    summary("rotation_seconds", "Logger thread time spent per rotation.", rotationNs, 1e-9);
+    if (endToEndNs.count > 0)
+        summary("end_to_end_seconds", "Time from the log call until the message was written.", endToEndNs, 1e-9);
+
+    perBuffer("buffer_capacity", "gauge", "Ring buffer capacity in messages.", &BufferMetrics::capacity);
+    perBuffer("buffer_occupancy", "gauge", "Messages waiting in the ring buffer.", &BufferMetrics::occupancy);
+    metric("buffer_fill_ratio", "gauge", "Fraction of the ring buffer in use.");
+    for (const auto &buffer : buffers)
+        out += std::format("blitz_buffer_fill_ratio{{thread=\"{:x}\"}} {:.4f}\n", buffer.threadHash,
+                           static_cast<double>(buffer.occupancy) / static_cast<double>(std::max<size_t>(buffer.capacity, 1)));
+    perBuffer("buffer_high_water_mark", "gauge", "Most messages ever waiting in the ring buffer.", &BufferMetrics::highWaterMark);
+    perBuffer("buffer_blocked_pushes_total", "counter", "Log calls that found this buffer full.", &BufferMetrics::blockedPushes);
+    return out;
+}
+
+void Logger::exportMetrics(const std::string &path) const
+{
+    // written next to the target and renamed, so scrapers never see a partial file
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        file << metrics().toPrometheus();
+        if (!file)
+            return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+}
+
+std::string Logger::metricsServerEndpoint() const
+{
+    std::shared_lock lock(configMutex);
+    return metricsServer ? metricsServer->endpoint() : std::string();
+}
+
+std::string Logger::latencyHistogramsJson() const
+{
+    blitz_histogram::Snapshot producer;
+    std::string threads;
+    {
+        std::lock_guard<std::mutex> lock(statsMapMutex);
+        for (const auto &[threadId, stats] : threadStatsMap)
+        {
+            auto snapshot = stats->producerLatency.snapshot();
+            threads += std::format("{}\"{:x}\":{}", threads.empty() ? "" : ",",
+                                   std::hash<std::thread::id>{}(threadId), snapshot.toJson());
+            producer.merge(snapshot);
+        }
+    }
+
+    return std::format(R"({{"producer":{},"producer_threads":{{{}}},"queue":{},"format_batch":{},"write":{},"end_to_end":{}}})",
+                       producer.toJson(), threads,
+                       stageHistograms.queue.snapshot().toJson(),
+                       stageHistograms.format.snapshot().toJson(),
+                       stageHistograms.write.snapshot().toJson(),
+                       stageHistograms.endToEnd.snapshot().toJson());
+}
+
+void Logger::completeFlush(
+    uint64_t generation,
+    std::vector<LogMessage> &batchBuffer,
+    std::vector<char> &fileBuffer,
+    std::vector<char> &consoleBuffer)
+{
+    bool sync;
+    {
+        std::lock_guard<std::mutex> lock(flushBarrier.mutex);
+        sync = flushBarrier.syncUpTo > flushBarrier.completed;
+    }
+
+    // messages logged before the request are below the current tails, later ones wait for the next pass
+    auto buffers = bufferRegistry.getAllBuffers();
+    for (auto &buffer : buffers)
+    {
+        const size_t target = buffer->tail.load(std::memory_order_acquire);
+        LogMessage msg;
+        while ((buffer->predecessor || buffer->head.load(std::memory_order_relaxed) != target) && buffer->pop(msg))
+        {
+            batchBuffer.push_back(std::move(msg));
+            if (batchBuffer.size() >= 4096)
+            {
+                processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
+            }
+        }
+    }
+    processAndClearBatch(batchBuffer, fileBuffer, consoleBuffer);
+
+    if (config.fileOutput && logFd >= 0)
+    {
+        flushPendingOutput();
+        if (sync)
+            syncLogFile(true);
+    }
+    if (config.consoleOutput)
+    {
+        std::cout.flush();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(flushBarrier.mutex);
+        flushBarrier.completed = generation;
+    }
+    flushBarrier.done.notify_all();
 }
 
 void Logger::processAndClearBatch(
@@ -482,17 +2319,25 @@ Logger::~Logger()
 {
     try
     {
+        metricsServer.reset(); // scrapes read the buffers and counters torn down below
         running.store(false, std::memory_order_release);
 
         if (loggerThread.joinable())
         {
             loggerThread.join();
         }
-        if (logFile.is_open())
+        if (config.synchronous)
+        {
+            flushSynchronous(syncEnabled(), true);
+        }
+        if (logFd >= 0)
         {
-            logFile.flush(); // final flush before closing
-            logFile.close();
+            closeLogFile(logFd);
+            logFd = -1;
         }
+        stopMaintenanceWorker(); // before the compression worker, rotations queue compressions
+        discardPreparedFile(preparedFile.exchange(nullptr));
+        stopCompressionWorker();
 
         std::lock_guard<std::mutex> lock(statsMapMutex);
         threadStatsMap.clear();
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -10,6 +13,7 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <shared_mutex>
 #include <source_location>
 #include <string>
@@ -19,6 +23,13 @@
 #include <cstring>
 #include <list>
 #include <unordered_map>
+#include <deque>
+
+#include "blitz_binary.hpp"
+#include "blitz_compress.hpp"
+#include "blitz_histogram.hpp"
+#include "blitz_http.hpp"
+#include "blitz_thread.hpp"
 
 class Logger
 {
@@ -35,6 +46,22 @@ public:
         STEP
     };
 
+    // when the active log file is rotated
+    enum class RotationPolicy
+    {
+        SIZE,        // when it reaches maxFileSize
+        TIME,        // every rotationInterval
+        SIZE_OR_TIME // whichever comes first
+    };
+
+    // output line layouts
+    enum class Layout
+    {
+        TEXT,  // [timestamp] [LEVEL] [T-id] [module] [file:line] message key=value
+        JSON,  // one JSON object per line
+        LOGFMT // key=value pairs
+    };
+
     // logger configuration
     struct Config
     {
@@ -42,6 +69,10 @@ public:
         std::string filePrefix{"app"};        // log file prefix
         size_t maxFileSize{10 * 1024 * 1024}; // max single file size (10MB)
         size_t maxFiles{5};                   // max number of files to keep
+        size_t maxTotalBytes{0};              // max total size of rotated files, 0 for no limit
+        std::chrono::seconds maxFileAge{0};   // delete rotated files older than this, 0 for no limit
+        RotationPolicy rotationPolicy{RotationPolicy::SIZE};
+        std::chrono::seconds rotationInterval{std::chrono::hours(24)}; // time based rotation period, aligned to local midnight
         Level minLevel{Level::INFO};          // minimum log level
         bool consoleOutput{true};             // enable console output
         bool fileOutput{true};                // enable file output
@@ -51,8 +82,94 @@ public:
         bool showSourceLocation{true};        // show source location in logs
         bool showModuleName{true};            // show module name in logs
         bool showFullPath{false};             // show full file paths in logs
+        bool deduplicateMessages{false};      // collapse repeated identical messages
+        size_t dedupWindowMs{1000};           // window for collapsing repeated messages
+        bool binaryOutput{false};             // write compact binary records (.blz), see blitz_decode
+        Layout layout{Layout::TEXT};          // text layout of file and console lines
+        bool sanitizeMessages{false};         // escape newlines/control characters in text layout messages
+        bool preallocateFiles{true};          // reserve maxFileSize on disk for the next file ahead of rotation
+        std::shared_ptr<const blitz_compress::Codec> compressionCodec{}; // compress rotated files in the background, null keeps them as is
+        bool compressLiveFile{false};         // compress the active file in frames as it is written (needs compressionCodec)
+        size_t flushIntervalMs{0};            // hold file output back up to this long to coalesce writes, 0 writes every batch
+        size_t flushBytes{1024 * 1024};       // write held back output once this much is pending
+        size_t syncIntervalMs{0};             // fdatasync the log file this often, 0 leaves it to the OS
+        bool syncOnError{false};              // write and fdatasync right after a batch with ERROR or FATAL messages
+        bool latencyHistograms{false};        // record per-stage latency histograms, see latencyHistogramsJson()
+        std::string metricsFile{};            // export metrics() in Prometheus text format to this file, empty disables
+        std::chrono::seconds metricsInterval{10}; // period of the metrics file export
+        std::string metricsEndpoint{};        // serve metrics over HTTP on "host:port" or "unix:/path.sock", empty disables
+        bool synchronous{false};              // format and write on the calling thread, no logger thread or ring buffers; fixed by initialize()
+        size_t bufferCapacity{1 << 16};       // ring slots per producer thread, rounded up to a power of two, see setThreadBufferCapacity()
+        size_t maxBufferCapacity{0};          // grow rings of threads that keep finding theirs full up to this many slots, 0 disables;
+                                              // threads that set their own capacity keep it
+        size_t preallocatedBuffers{0};        // rings mapped and faulted in by initialize() for this many threads, 0 allocates on first use
+        size_t pooledBuffers{4};              // rings of exited threads kept for new ones, on top of preallocatedBuffers
+        bool numaLocalBuffers{false};         // place each thread's ring on the NUMA node it runs on, preallocated rings spread over all nodes
+        int loggerNumaNode{-1};               // pin the logger thread to the CPUs of this NUMA node, -1 leaves it unpinned
+        // name, CPUs and scheduling of the background threads, applied when each thread starts; cpus
+        // of the logger thread take precedence over loggerNumaNode
+        blitz_thread::Options loggerThreadOptions{.name = "blitz-logger"};
+        blitz_thread::Options maintenanceThreadOptions{.name = "blitz-maint"};             // rotation, retention, metrics file
+        blitz_thread::Options compressionThreadOptions{.name = "blitz-compress", .nice = 19}; // rotated file compression
+        blitz_thread::Options metricsThreadOptions{.name = "blitz-metrics"};               // HTTP metrics endpoint
+    };
+
+    // state of one producer thread's ring buffer
+    struct BufferMetrics
+    {
+        size_t threadHash;
+        size_t capacity;
+        size_t occupancy;        // messages waiting right now
+        size_t highWaterMark;    // most messages ever waiting at once
+        uint64_t blockedPushes;  // pushes that found the buffer full
+        uint64_t yieldSpins;     // yields while waiting for space
+        int numaNode;            // node the ring's pages come from, -1 when not placed
+    };
+
+    // point in time copy of the logger's counters, see metrics()
+    struct Metrics
+    {
+        std::vector<BufferMetrics> buffers;
+        uint64_t messagesProduced{0};
+        uint64_t messagesConsumed{0};
+        uint64_t messagesDropped{0}; // log calls that failed, e.g. on a formatting exception
+        uint64_t blockedPushes{0};   // summed over all buffers, retired ones included
+        uint64_t yieldSpins{0};
+        uint64_t fileBytes{0};       // written to log files, after compression
+        uint64_t consoleBytes{0};
+        uint64_t writeErrors{0};     // failed file writes, each dropping the rest of its batch
+        uint64_t fileSyncs{0};       // fdatasync calls on the active log file
+        uint64_t bytesDropped{0};
+        uint64_t bufferGrowths{0};   // larger rings handed to threads that kept finding theirs full
+        uint64_t buffersRetired{0};  // rings of exited threads, drained and released
+        uint64_t buffersReused{0};   // rings handed to a new thread from the pool instead of allocated
+        blitz_histogram::Snapshot batchSizes;  // messages per consumer batch
+        blitz_histogram::Snapshot rotationNs;  // logger thread time per rotation, count is the rotation count
+        blitz_histogram::Snapshot endToEndNs;  // log call until written, empty unless Config::latencyHistograms
+
+        // messages logged but not yet taken by the logger thread
+        uint64_t consumerLag() const { return messagesProduced > messagesConsumed ? messagesProduced - messagesConsumed : 0; }
+
+        // Prometheus text exposition format, metric names prefixed with blitz_
+        std::string toPrometheus() const;
+    };
+
+    // a single rendered log line, shared by the logger thread and blitz_decode
+    struct RecordView
+    {
+        Level level;
+        std::chrono::system_clock::time_point timestamp;
+        size_t threadHash;
+        std::string_view module;
+        std::string_view file;
+        int line;
+        std::string_view message;
+        std::string_view fields; // encoded key-value fields, see LOG_*_KV
     };
 
+    // append the text layout of a record to buffer (without trailing newline)
+    static void formatRecord(const Config &config, const RecordView &record, std::vector<char> &buffer) noexcept;
+
 private:
     // log context information
     struct Context
@@ -85,10 +202,13 @@ private:
     // log message structure
     struct alignas(64) LogMessage
     {
-        std::string message;
+        std::string message; // formatted text, or encoded arguments when format is set
+        std::string_view format; // format string of a binary encoded message, empty for text
+        std::string fields;      // encoded key-value fields, see LOG_*_KV
         Level level;
         Context context;
         std::chrono::system_clock::time_point timestamp;
+        std::chrono::steady_clock::time_point calledAt{}; // log call on a monotonic clock, only with Config::latencyHistograms
 
         LogMessage() = default;
 
@@ -106,51 +226,160 @@ private:
         ~LogMessage() = default;
     };
 
+    struct BufferArena;
+
     // thread-local buffer
     struct alignas(64) ThreadLocalBuffer
     {
-        static constexpr size_t BUFFER_SIZE = 1 << 16;
+        static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+        // raw storage for one message: push constructs the message in place and pop destroys it,
+        // so a ring costs no more memory than the pages its messages have reached
+        struct alignas(alignof(LogMessage)) Slot
+        {
+            std::byte storage[sizeof(LogMessage)];
+        };
 
-        alignas(64) std::array<LogMessage, BUFFER_SIZE> messages;
+        const size_t capacity;              // power of two, one slot stays free to tell full from empty
+        Slot *slots{nullptr};
+        std::shared_ptr<BufferArena> arena; // slots go back here, mapped ones always, allocated ones while the pool has room
+        int numaNode{-1};                   // node of the slots' pages, -1 when not placed
+        // each index shares its line with the other side's last seen value of it, so a push only reads
+        // head when the ring looks full and a pop only reads tail when it looks empty
         alignas(64) std::atomic<size_t> head{0};
+        size_t cachedTail{0}; // consumer only
         alignas(64) std::atomic<size_t> tail{0};
-        alignas(64) std::atomic<bool> isActive{true};
+        size_t cachedHead{0}; // producer only
+        alignas(64) std::atomic<bool> isActive{true}; // cleared when the owner exits, the logger thread retires the ring once drained
+        std::atomic<ThreadLocalBuffer *> offeredRing{nullptr}; // larger ring from the logger thread, taken on the next log call
         std::thread::id ownerThreadId;
 
-        ThreadLocalBuffer() : ownerThreadId(std::this_thread::get_id()) {}
+        // ring this one replaced, drained first so the thread's messages stay in order; set before
+        // the ring is registered, then only touched by the logger thread
+        std::shared_ptr<ThreadLocalBuffer> predecessor;
+        uint64_t blockedPushesSeen{0}; // logger thread only, blockedPushes at the last growth check
+        std::atomic<bool> fixedCapacity{false}; // sized by setThreadBufferCapacity(), never grown
+
+        // backpressure counters, written by the producer only, except the high water mark which the
+        // consumer samples whenever it reads tail
+        std::atomic<size_t> highWaterMark{0};
+        std::atomic<uint64_t> blockedPushes{0};
+        std::atomic<uint64_t> yieldSpins{0};
+
+        // takes a ring from the arena when it has one of the right capacity on node, allocates one on
+        // node otherwise (any node for -1); either way the slots go back to the arena afterwards
+        explicit ThreadLocalBuffer(size_t requestedCapacity = DEFAULT_CAPACITY, std::shared_ptr<BufferArena> from = nullptr,
+                                   int node = -1);
+        ~ThreadLocalBuffer();
+
+        // slots straight from mmap, so the pages stay untouched until messages reach them; throws std::bad_alloc
+        static Slot *allocateSlots(size_t capacity, int node);
+        static void freeSlots(Slot *slots, size_t capacity) noexcept;
+
+        ThreadLocalBuffer(const ThreadLocalBuffer &) = delete;
+        ThreadLocalBuffer &operator=(const ThreadLocalBuffer &) = delete;
+
+        static size_t roundCapacity(size_t requested) noexcept
+        {
+            return std::bit_ceil(std::max<size_t>(requested, 16));
+        }
+
+        LogMessage &at(size_t index) noexcept
+        {
+            return *std::launder(reinterpret_cast<LogMessage *>(&slots[index]));
+        }
 
         void push(LogMessage &&msg) noexcept
         {
-            while (true)
-            {
-                auto current_tail = tail.load(std::memory_order_relaxed);
-                auto next_tail = (current_tail + 1) & (BUFFER_SIZE - 1);
+            const auto current_tail = tail.load(std::memory_order_relaxed);
+            const auto next_tail = (current_tail + 1) & (capacity - 1);
 
-                if (next_tail != head.load(std::memory_order_acquire))
+            if (next_tail == cachedHead) [[unlikely]]
+            {
+                bool blocked = false;
+                while ((cachedHead = head.load(std::memory_order_acquire)) == next_tail)
                 {
-                    new (&messages[current_tail]) LogMessage(std::move(msg));
-                    tail.store(next_tail, std::memory_order_release);
-                    return;
+                    // if buffer is full, yield and retry
+                    if (!blocked)
+                    {
+                        blocked = true;
+                        bump(blockedPushes);
+                    }
+                    bump(yieldSpins);
+                    std::this_thread::yield();
                 }
-
-                // if buffer is full, yield and retry
-                std::this_thread::yield();
             }
+
+            new (&slots[current_tail]) LogMessage(std::move(msg));
+            tail.store(next_tail, std::memory_order_release);
+        }
+
+        static void bump(std::atomic<uint64_t> &counter) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        // consumer side: rereads tail, returns the messages waiting behind current_head
+        size_t refreshTail(size_t current_head) noexcept
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            size_t used = (cachedTail - current_head) & (capacity - 1);
+            if (used > highWaterMark.load(std::memory_order_relaxed))
+                highWaterMark.store(used, std::memory_order_relaxed);
+            return used;
         }
 
         bool pop(LogMessage &msg) noexcept
         {
-            auto current_head = head.load(std::memory_order_relaxed);
-            auto current_tail = tail.load(std::memory_order_acquire);
+            if (predecessor) [[unlikely]]
+            {
+                if (predecessor->pop(msg))
+                    return true;
+                predecessor.reset(); // the producer moved on before registering this ring, so it stays empty
+            }
 
-            if (current_head == current_tail)
+            auto current_head = head.load(std::memory_order_relaxed);
+            if (current_head == cachedTail && refreshTail(current_head) == 0)
                 return false; // buffer empty
 
-            msg = std::move(messages[current_head]);
-            head.store((current_head + 1) & (BUFFER_SIZE - 1), std::memory_order_release);
+            LogMessage &slot = at(current_head);
+            msg = std::move(slot);
+            slot.~LogMessage();
+            head.store((current_head + 1) & (capacity - 1), std::memory_order_release);
             return true;
         }
 
+        // moves up to max messages to the end of out and publishes head once for all of them;
+        // out should have room reserved, the logger thread's batch does
+        size_t popBatch(std::vector<LogMessage> &out, size_t max)
+        {
+            size_t taken = 0;
+            if (predecessor) [[unlikely]]
+            {
+                taken = predecessor->popBatch(out, max);
+                if (taken == max)
+                    return taken;
+                predecessor.reset(); // drained, see pop()
+            }
+
+            auto current_head = head.load(std::memory_order_relaxed);
+            size_t available = (cachedTail - current_head) & (capacity - 1);
+            if (available < max - taken)
+                available = refreshTail(current_head);
+
+            const size_t count = std::min(available, max - taken);
+            for (size_t i = 0; i < count; ++i)
+            {
+                LogMessage &slot = at(current_head);
+                out.push_back(std::move(slot));
+                slot.~LogMessage();
+                current_head = (current_head + 1) & (capacity - 1);
+            }
+            if (count > 0)
+                head.store(current_head, std::memory_order_release);
+            return taken + count;
+        }
+
         bool isEmpty() const noexcept
         {
             return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_relaxed);
@@ -160,16 +389,55 @@ private:
         {
             auto h = head.load(std::memory_order_relaxed);
             auto t = tail.load(std::memory_order_relaxed);
-            return (t >= h) ? (t - h) : (BUFFER_SIZE - (h - t));
+            return (t >= h) ? (t - h) : (capacity - (h - t));
         }
 
         // check if buffer is nearly full (90% capacity)
         bool isNearlyFull() const noexcept
         {
-            return size() > (BUFFER_SIZE * 0.9);
+            return size() > (capacity * 0.9);
         }
     };
 
+    // rings for Config::preallocatedBuffers threads in one mapping made by initialize(), so the first
+    // log call of a thread takes a ring off the free list instead of allocating and faulting one in.
+    // rings of exited threads come back here, warm, for the next thread that needs that capacity
+    struct BufferArena
+    {
+        using Slot = ThreadLocalBuffer::Slot;
+
+        struct FreeRing
+        {
+            Slot *slots{nullptr};
+            size_t capacity{0};
+            int node{-1};
+        };
+
+        // spreadNodes binds the mapped rings round-robin to the NUMA nodes
+        BufferArena(size_t rings, size_t ringCapacity, size_t pooledRings = 0, bool spreadNodes = false);
+        ~BufferArena();
+
+        BufferArena(const BufferArena &) = delete;
+        BufferArena &operator=(const BufferArena &) = delete;
+
+        // a released ring only on node (any for -1), a fresh mapped one preferably on node;
+        // slots is nullptr when no free ring has this capacity
+        FreeRing acquire(size_t ringCapacity, int node);
+        void release(const FreeRing &ring); // pooled, or freed when the pool is full
+
+        bool owns(const Slot *ring) const noexcept;
+
+        const size_t capacity;  // slots per mapped ring
+        const size_t maxPooled; // allocated rings kept for reuse, mapped rings are always kept
+        void *memory{nullptr};
+        size_t bytes{0};
+        std::mutex mutex;
+        std::vector<FreeRing> freeRings; // mapped rings never handed out
+        std::vector<FreeRing> usedRings; // released rings, reused first
+        size_t pooledAllocations{0};     // allocated rings in usedRings
+        std::atomic<uint64_t> reused{0};
+    };
+
     struct BufferRegistry
     {
         std::mutex registryMutex;
@@ -181,10 +449,15 @@ private:
             buffers.push_back(buffer);
         }
 
-        void unregisterBuffer(std::shared_ptr<ThreadLocalBuffer> buffer)
+        // the new ring takes the old one's place, so the round-robin order stays the same
+        void replaceBuffer(const std::shared_ptr<ThreadLocalBuffer> &old, std::shared_ptr<ThreadLocalBuffer> buffer)
         {
             std::lock_guard<std::mutex> lock(registryMutex);
-            buffers.remove(buffer);
+            auto it = std::find(buffers.begin(), buffers.end(), old);
+            if (it != buffers.end())
+                *it = std::move(buffer);
+            else
+                buffers.push_back(std::move(buffer));
         }
 
         std::vector<std::shared_ptr<ThreadLocalBuffer>> getAllBuffers()
@@ -194,28 +467,276 @@ private:
         }
     };
 
-    static ThreadLocalBuffer &getThreadLocalBuffer();
+    // consumer side table of recently written messages, keyed by call site and message hash
+    struct DuplicateFilter
+    {
+        static constexpr size_t TABLE_SIZE = 256;
+
+        struct Entry
+        {
+            size_t key{0};
+            bool used{false};
+            size_t repeats{0}; // identical messages suppressed since firstSeen
+            Level level{Level::INFO};
+            Context context;
+            std::string message;
+            std::string_view format;
+            std::string fields;
+            std::chrono::system_clock::time_point firstSeen;
+        };
+
+        std::array<Entry, TABLE_SIZE> entries;
+        size_t pendingEntries{0}; // entries with repeats > 0
+    };
+
+    // per file dictionaries of the binary encoder, reset whenever a new file is opened
+    struct BinaryWriter
+    {
+        struct CallSiteKey
+        {
+            std::string_view format;
+            std::string_view file;
+            int line;
+            Level level;
+
+            bool operator==(const CallSiteKey &) const = default;
+        };
+
+        struct CallSiteKeyHash
+        {
+            size_t operator()(const CallSiteKey &key) const noexcept
+            {
+                size_t h = std::hash<const void *>{}(key.format.data());
+                h ^= std::hash<std::string_view>{}(key.file) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+                return h ^ (static_cast<size_t>(key.line) << 3) ^ static_cast<size_t>(key.level);
+            }
+        };
+
+        bool headerPending{true};
+        int64_t lastTimestampNs{0};
+        std::unordered_map<CallSiteKey, uint32_t, CallSiteKeyHash> callSites;
+        std::unordered_map<std::string, uint32_t> modules;
+        std::unordered_map<std::thread::id, uint32_t> threads;
+        std::deque<std::string> fileNames; // owns the file names referenced by callSites keys
+        std::string scratch;
+
+        void reset()
+        {
+            headerPending = true;
+            callSites.clear();
+            modules.clear();
+            threads.clear();
+            fileNames.clear();
+        }
+    };
+
+    // low priority thread compressing rotated files, started on first use
+    struct CompressionWorker
+    {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::deque<std::pair<std::string, std::shared_ptr<const blitz_compress::Codec>>> pending;
+        std::string active; // file being compressed, its partial output must survive a rescan
+        bool stopping{false};
+    };
+
+    // where rotated files live and which of them to keep
+    struct RetentionSettings
+    {
+        std::string logDir;
+        std::string filePrefix;
+        std::string extension;           // of the active file, including a live compression extension
+        std::string compressedExtension; // added by background compression, empty without it
+        size_t maxFiles{0};
+        size_t maxTotalBytes{0};
+        std::chrono::seconds maxFileAge{0};
+    };
+
+    // work for the maintenance thread, a rotation handed over by the logger thread or, without
+    // retiredFd, a rescan after configure(); carries copies of everything so configure() can run concurrently
+    struct MaintenanceJob
+    {
+        int retiredFd{-1};       // descriptor of the finished file, closed by the maintenance thread
+        size_t retiredBytes{0};  // size of the finished file
+        std::string activePath;  // finished file, still under the active name
+        std::string stagingPath; // file the logger thread writes to now, renamed to activePath
+        std::chrono::system_clock::time_point openedAt;     // start of the finished file, used in its name
+        std::shared_ptr<const blitz_compress::Codec> codec; // compress the rotated file with this, may be null
+        RetentionSettings retention;
+        size_t preallocateBytes{0}; // reserved for the next prepared file
+        bool syncRetired{false};    // fdatasync the finished file before closing it
+        std::string metricsFile;    // periodic metrics export, empty disables
+        std::chrono::seconds metricsInterval{0};
+    };
+
+    // next log file, opened and preallocated by the maintenance thread ahead of rotation
+    struct PreparedFile
+    {
+        int fd;
+        std::string path;       // staging path
+        std::string activePath; // active file it is going to replace
+    };
+
+    struct RotatedFile
+    {
+        std::string path; // without compression extension
+        size_t bytes;     // on disk, updated once compressed
+        std::chrono::system_clock::time_point modified;
+        bool compressed;
+    };
+
+    // renames rotated files and applies retention
+    struct MaintenanceWorker
+    {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::deque<MaintenanceJob> pending;
+        bool stopping{false};
+
+        // only touched by the maintenance thread
+        RetentionSettings retention;          // of the latest job, for periodic age checks
+        std::string metricsFile;              // of the latest job
+        std::chrono::seconds metricsInterval{0};
+        std::deque<RotatedFile> rotatedFiles; // oldest first
+        uint64_t nextSequence{1};             // continues after the highest sequence found on disk
+    };
+
+    // flush() requests, numbered so concurrent callers share one pass of the logger thread
+    struct FlushBarrier
+    {
+        std::mutex mutex;
+        std::condition_variable wakeup; // wakes the idle logger thread
+        std::condition_variable done;   // wakes flush() callers
+        std::atomic<uint64_t> requested{0};
+        uint64_t completed{0}; // guarded by mutex
+        uint64_t syncUpTo{0};  // latest request asking for fdatasync, guarded by mutex
+    };
+
+    // output held back by the logger thread, the raw bytes of the next frame with compressLiveFile,
+    // otherwise text coalesced into fewer writes when flushIntervalMs is set
+    struct PendingOutput
+    {
+        static constexpr size_t FRAME_SIZE = 256 * 1024;
+        static constexpr std::chrono::seconds MAX_DELAY{1}; // bound on unwritten frame data without flushIntervalMs
+
+        std::vector<char> raw;
+        std::vector<char> compressed;
+        std::chrono::steady_clock::time_point firstByte;
+    };
+
+    // the calling thread's ring, unregistered when the thread exits
+    struct LocalBuffer
+    {
+        std::shared_ptr<ThreadLocalBuffer> buffer;
+        size_t capacity{0}; // setThreadBufferCapacity(), 0 uses Config::bufferCapacity
+        ~LocalBuffer();
+    };
+
+    static LocalBuffer &localBuffer();
+    int ringNode() const noexcept;
+    ThreadLocalBuffer &getThreadLocalBuffer();
+    void switchThreadBuffer(LocalBuffer &local, std::shared_ptr<ThreadLocalBuffer> next);
+    void offerLargerRing(ThreadLocalBuffer &buffer);
+    void retireBuffer(const std::shared_ptr<ThreadLocalBuffer> &buffer);
+    static void applyThreadOptions(const blitz_thread::Options &options);
+
+    // encode alternating key/value pairs, values that cannot be encoded are stored as text
+    static void encodeFields(std::string &) {}
+
+    template <typename Key, typename Value, typename... Rest>
+    static void encodeFields(std::string &out, const Key &key, const Value &value, const Rest &...rest)
+    {
+        static_assert(std::is_convertible_v<const Key &, std::string_view>, "field keys must be strings");
+
+        blitz_binary::encodeArg(out, std::string_view(key));
+        if constexpr (blitz_binary::Encodable<Value>)
+            blitz_binary::encodeArg(out, value);
+        else
+            blitz_binary::encodeArg(out, std::format("{}", value));
+
+        encodeFields(out, rest...);
+    }
 
     static BufferRegistry bufferRegistry;
     struct ThreadStats
     {
         std::atomic<size_t> messagesProduced{0};
         std::thread::id threadId;
+        blitz_histogram::Histogram producerLatency; // log call until the message is queued
+    };
+
+    // counters behind metrics()
+    struct RuntimeCounters
+    {
+        std::atomic<uint64_t> messagesDropped{0};
+        std::atomic<uint64_t> messagesConsumed{0};
+        std::atomic<uint64_t> fileBytes{0};
+        std::atomic<uint64_t> consoleBytes{0};
+        std::atomic<uint64_t> writeErrors{0};
+        std::atomic<uint64_t> fileSyncs{0};
+        std::atomic<uint64_t> bytesDropped{0};
+        std::atomic<uint64_t> bufferGrowths{0};
+        std::atomic<uint64_t> buffersRetired{0};
+        // backpressure of retired rings, added under the registry lock as the ring leaves it
+        std::atomic<uint64_t> retiredBlockedPushes{0};
+        std::atomic<uint64_t> retiredYieldSpins{0};
+        blitz_histogram::Histogram batchSizes; // written by the logger thread only
+        blitz_histogram::Histogram rotationNs; // written by the logger thread only
+    };
+
+    // consumer side latency stages, written by the logger thread only
+    struct StageHistograms
+    {
+        blitz_histogram::Histogram queue;  // log call until the logger thread picks the message up
+        blitz_histogram::Histogram format; // formatting one batch
+        blitz_histogram::Histogram write;  // one write to the log file
+        blitz_histogram::Histogram endToEnd; // log call until the write containing the message returned
     };
 
     std::unordered_map<std::thread::id, std::shared_ptr<ThreadStats>> threadStatsMap;
     mutable std::mutex statsMapMutex;
+    StageHistograms stageHistograms;
+    RuntimeCounters counters;
+    std::unique_ptr<blitz_http::MetricsServer> metricsServer;
+
+    // latency stages run on the steady clock, a wall clock step would clamp or inflate them
+    static uint64_t elapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) noexcept
+    {
+        return static_cast<uint64_t>(std::max<int64_t>(
+            0, std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count()));
+    }
 
-    void updateThreadStats();
+    void updateThreadStats(std::chrono::steady_clock::time_point calledAt);
     void processMessageBatch(const std::vector<LogMessage> &batch,
                              std::vector<char> &fileBuffer,
                              std::vector<char> &consoleBuffer);
+    void appendMessage(const LogMessage &msg,
+                       std::vector<char> &fileBuffer,
+                       std::vector<char> &consoleBuffer);
+    void writeOutput(const std::vector<char> &fileBuffer, const std::vector<char> &consoleBuffer, bool urgent);
+    void writeSynchronous(const LogMessage &msg);
+    void flushSynchronous(bool sync, bool shutdown);
+    void appendRepeatSummary(const DuplicateFilter::Entry &entry,
+                             std::vector<char> &fileBuffer,
+                             std::vector<char> &consoleBuffer);
+    bool suppressDuplicate(const LogMessage &msg,
+                           std::vector<char> &fileBuffer,
+                           std::vector<char> &consoleBuffer);
+    void flushRepeatedMessages(bool force,
+                               std::vector<char> &fileBuffer,
+                               std::vector<char> &consoleBuffer);
     void processAndClearBatch(std::vector<LogMessage> &batchBuffer,
                               std::vector<char> &fileBuffer,
                               std::vector<char> &consoleBuffer);
     void drainAllBuffers(std::vector<LogMessage> &batchBuffer,
                          std::vector<char> &fileBuffer,
                          std::vector<char> &consoleBuffer);
+    void completeFlush(uint64_t generation,
+                       std::vector<LogMessage> &batchBuffer,
+                       std::vector<char> &fileBuffer,
+                       std::vector<char> &consoleBuffer);
 
     // terminal colors
     static constexpr std::array<const char *, 10> COLORS = {
@@ -246,10 +767,27 @@ private:
     // member variables
     Config config;
     mutable std::shared_mutex configMutex; // for config changes
-    std::ofstream logFile;
+    int logFd{-1}; // active log file, written by the logger thread
+    std::atomic<uint64_t> stagingSequence{0};                  // names staging files
+    const std::string stagingTag{newStagingTag()};             // tells this process' staging files from ones a crash left behind
+    std::atomic<PreparedFile *> preparedFile{nullptr};         // handed from the maintenance to the logger thread
+    std::atomic<bool> rotationRequested{false};
+    std::chrono::system_clock::time_point currentFileOpenedAt; // only touched by the logger thread
+    std::chrono::system_clock::time_point nextRotationTime;    // only touched by the logger thread
     std::thread loggerThread;
     std::atomic<bool> running{true};
+    bool started{false};             // initialize() finished, the synchronous mode is fixed from here on
+    std::shared_ptr<BufferArena> bufferArena; // set by initialize() with Config::preallocatedBuffers or pooledBuffers
+    std::mutex syncMutex;            // serializes the sinks in synchronous mode, standing in for the logger thread below
     std::atomic<size_t> currentFileSize{0};
+    DuplicateFilter duplicateFilter; // only touched by the logger thread
+    BinaryWriter binaryWriter;       // only touched by the logger thread
+    PendingOutput pendingOutput;     // only touched by the logger thread
+    std::chrono::steady_clock::time_point lastSync; // only touched by the logger thread
+    bool unsyncedWrites{false};      // written since the last fdatasync, only touched by the logger thread
+    FlushBarrier flushBarrier;
+    CompressionWorker compressionWorker;
+    MaintenanceWorker maintenanceWorker;
     static inline std::unique_ptr<Logger> instance;
     static inline std::once_flag initFlag;
 
@@ -257,8 +795,41 @@ private:
     Logger();
     void processLogs();
     void rotateLogFileIfNeeded();
+    void rotateLogFile(std::chrono::system_clock::time_point now);
+    void scheduleRotation(std::chrono::system_clock::time_point now);
+    RetentionSettings retentionSettings() const;
     void cleanOldLogs();
+    void scanRotatedFiles();
+    static std::string newStagingTag();
+    std::string nextStagingPath(const std::string &activePath);
+    std::string nextRotatedPath(std::chrono::system_clock::time_point openedAt);
+    void finishRotation(MaintenanceJob &job);
+    void enqueueMaintenance(MaintenanceJob job);
+    void prepareNextFile(const MaintenanceJob &job);
+    static void discardPreparedFile(PreparedFile *file);
+    void runMaintenanceWorker();
+    void exportMetrics(const std::string &path) const;
+    void stopMaintenanceWorker();
+    static int openLogFile(const std::string &path);
+    static void closeLogFile(int fd);
+    void writeToLogFile(const std::vector<char> &data);
+    void writeToFd(const char *data, size_t size);
+    void flushPendingOutput();
+    bool pendingOutputDue(std::chrono::steady_clock::time_point now) const;
+    bool syncEnabled() const;
+    void syncLogFile(bool urgent);
+    bool liveCompression() const;
+    void enqueueCompression(std::string path, std::shared_ptr<const blitz_compress::Codec> codec);
+    void runCompressionWorker();
+    void stopCompressionWorker();
     void formatLogMessage(const LogMessage &msg, std::vector<char> &buffer) noexcept;
+    static void formatJsonRecord(const Config &config, const RecordView &record, std::vector<char> &buffer);
+    static void formatLogfmtRecord(const Config &config, const RecordView &record, std::vector<char> &buffer);
+    static void appendFields(std::string_view fields, bool json, std::vector<char> &buffer);
+    void encodeBinaryMessage(const LogMessage &msg, std::vector<char> &buffer);
+    std::string logFileExtension() const;
+    std::string activeFileExtension() const;
+    std::string logFilePath() const;
     const char *getLevelColor(Level level) const;
 
 public:
@@ -267,10 +838,123 @@ public:
     static void destroyInstance();
 
     void configure(const Config &cfg);
+    void rotate(); // rotate the log file after the messages queued so far
+
+    // wait until everything logged before the call is written (and with sync, fdatasync'ed),
+    // false if that took longer than timeout
+    bool flush(std::chrono::milliseconds timeout = std::chrono::seconds(5), bool sync = false);
     void setLogLevel(Level level);
     void setModuleName(std::string_view module);
+
+    // ring capacity for the calling thread, overriding Config::bufferCapacity; called before the
+    // thread's first log it sizes the first ring, afterwards the thread moves to a new ring;
+    // 0 returns to Config::bufferCapacity and lets the ring grow again
+    void setThreadBufferCapacity(size_t capacity);
     void printStats() const;
+
+    // snapshot of queue, throughput and rotation counters, safe to call from any thread
+    Metrics metrics() const;
+
+    // address the metrics server listens on, with the actual port, empty if it is disabled
+    std::string metricsServerEndpoint() const;
+
+    // latency histograms in nanoseconds as JSON: producer call (aggregate and per thread), queue
+    // residence, batch formatting and file writes; all empty unless Config::latencyHistograms is set
+    std::string latencyHistogramsJson() const;
     friend std::unique_ptr<Logger> std::make_unique<Logger>();
+    friend struct LoggerBenchAccess; // internals exercised by the microbenchmarks in bench/
+
+    // per call site limiter state, one static instance per LOG_*_EVERY_N/FIRST_N/EVERY_MS/RATE_LIMITED site
+    class CallSiteLimiter
+    {
+    public:
+        // allow the 1st, (n+1)th, (2n+1)th... call
+        bool everyN(uint64_t n) noexcept
+        {
+            if (n <= 1 || counter.fetch_add(1, std::memory_order_relaxed) % n == 0)
+                return true;
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // allow only the first n calls; the site never reopens, so suppression is silent
+        bool firstN(uint64_t n) noexcept
+        {
+            return counter.load(std::memory_order_relaxed) < n &&
+                   counter.fetch_add(1, std::memory_order_relaxed) < n;
+        }
+
+        // allow at most one call per interval
+        bool everyMs(uint64_t ms) noexcept
+        {
+            const int64_t now = nowNs();
+            const int64_t interval = static_cast<int64_t>(ms) * 1'000'000;
+            int64_t last = stateNs.load(std::memory_order_relaxed);
+
+            while (last == 0 || now - last >= interval)
+            {
+                if (stateNs.compare_exchange_weak(last, now, std::memory_order_relaxed))
+                    return true;
+            }
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // token bucket with `perSecond` refill rate and `burst` capacity,
+        // implemented as GCRA so the whole state fits in one atomic
+        bool rateLimited(double perSecond, uint64_t burst) noexcept
+        {
+            if (!(perSecond > 0.0)) // NaN too
+            {
+                suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // clamped in floating point, so tiny rates and huge bursts cannot overflow tat
+            const int64_t now = nowNs();
+            const double emissionNs = std::min(1e9 / perSecond, MAX_SPAN_NS);
+            const int64_t emission = static_cast<int64_t>(emissionNs);
+            const int64_t tolerance = static_cast<int64_t>(
+                std::min(emissionNs * static_cast<double>(burst > 0 ? burst - 1 : 0), MAX_SPAN_NS));
+            int64_t tat = stateNs.load(std::memory_order_relaxed); // theoretical arrival time
+
+            while (now >= tat - tolerance)
+            {
+                if (stateNs.compare_exchange_weak(tat, std::max(tat, now) + emission, std::memory_order_relaxed))
+                    return true;
+            }
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // number of calls dropped since the last successful one
+        uint64_t takeSuppressed() noexcept
+        {
+            if (suppressed.load(std::memory_order_relaxed) == 0)
+                return 0;
+            return suppressed.exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        // ~31 years, tat stays below now + 2 * MAX_SPAN_NS which fits int64_t
+        static constexpr double MAX_SPAN_NS = 1e18;
+
+        static int64_t nowNs() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        std::atomic<uint64_t> counter{0};
+        std::atomic<int64_t> stateNs{0};
+        std::atomic<uint64_t> suppressed{0};
+    };
+
+    [[nodiscard]] bool isLevelEnabled(Level level) const noexcept
+    {
+        return level >= config.minLevel;
+    }
 
     // log method
     template <typename... Args>
@@ -281,20 +965,63 @@ public:
 
         try
         {
-            LogMessage msg{
-                std::format(fmt, std::forward<Args>(args)...),
-                level,
-                Context(loc)};
+            LogMessage msg{{}, level, Context(loc)};
+            if (config.latencyHistograms)
+                msg.calledAt = std::chrono::steady_clock::now();
+
+            // binary output defers formatting to blitz_decode when every argument can be encoded
+            if constexpr (blitz_binary::AllEncodable<Args...>)
+            {
+                if (config.binaryOutput)
+                {
+                    msg.format = fmt.get();
+                    blitz_binary::encodeArgs(msg.message, args...);
+                }
+            }
+            if (msg.format.empty())
+                msg.message = std::format(fmt, std::forward<Args>(args)...);
+
+            // push message to thread-local buffer, or write it right away in synchronous mode
+            const auto calledAt = msg.calledAt;
+            if (config.synchronous)
+                writeSynchronous(msg);
+            else
+                getThreadLocalBuffer().push(std::move(msg));
+            updateThreadStats(calledAt);
+        }
+        catch (const std::exception &e)
+        {
+            counters.messagesDropped.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "Logging error: " << e.what() << std::endl;
+        }
+    }
+
+    // structured log method, fields are alternating keys and values stored without rendering
+    template <typename... Fields>
+    void logKV(const std::source_location &loc, Level level, std::string_view message, Fields &&...fields)
+    {
+        static_assert(sizeof...(Fields) % 2 == 0, "structured logging needs key/value pairs");
 
-            // get thread-local buffer
-            auto &buffer = getThreadLocalBuffer();
+        if (level < config.minLevel)
+            return;
 
-            // push message to thread-local buffer
-            buffer.push(std::move(msg));
-            updateThreadStats();
+        try
+        {
+            LogMessage msg{std::string(message), level, Context(loc)};
+            if (config.latencyHistograms)
+                msg.calledAt = std::chrono::steady_clock::now();
+            encodeFields(msg.fields, fields...);
+
+            const auto calledAt = msg.calledAt;
+            if (config.synchronous)
+                writeSynchronous(msg);
+            else
+                getThreadLocalBuffer().push(std::move(msg));
+            updateThreadStats(calledAt);
         }
         catch (const std::exception &e)
         {
+            counters.messagesDropped.fetch_add(1, std::memory_order_relaxed);
             std::cerr << "Logging error: " << e.what() << std::endl;
         }
     }
@@ -343,6 +1070,17 @@ public:
             std::format(fmt, std::forward<Args>(args)...));
     }
 
+    // log through a call site limiter that already admitted this call,
+    // emitting a summary of the calls it dropped since the last one
+    template <typename... Args>
+    void logLimited(CallSiteLimiter &limiter, const std::source_location &loc, Level level,
+                    std::format_string<Args...> fmt, Args &&...args)
+    {
+        if (auto suppressed = limiter.takeSuppressed())
+            log(loc, level, "Suppressed {} messages from this call site", suppressed);
+        log(loc, level, fmt, std::forward<Args>(args)...);
+    }
+
     ~Logger();
 
     Logger(const Logger &) = delete;
@@ -358,4 +1096,50 @@ public:
 #define LOG_WARNING(...) Logger::getInstance()->warning(std::source_location::current(), __VA_ARGS__)
 #define LOG_ERROR(...) Logger::getInstance()->error(std::source_location::current(), __VA_ARGS__)
 #define LOG_FATAL(...) Logger::getInstance()->fatal(std::source_location::current(), __VA_ARGS__)
-#define LOG_STEP(num, ...) Logger::getInstance()->step(num, std::source_location::current(), __VA_ARGS__)
\ No newline at end of file
+#define LOG_STEP(num, ...) Logger::getInstance()->step(num, std::source_location::current(), __VA_ARGS__)
+
+// helper macros for structured logging: LOG_INFO_KV("request done", "latency_us", lat, "status", code)
+#define LOG_TRACE_KV(...) Logger::getInstance()->logKV(std::source_location::current(), Logger::Level::TRACE, __VA_ARGS__)
+#define LOG_DEBUG_KV(...) Logger::getInstance()->logKV(std::source_location::current(), Logger::Level::DEBUG, __VA_ARGS__)
+#define LOG_INFO_KV(...) Logger::getInstance()->logKV(std::source_location::current(), Logger::Level::INFO, __VA_ARGS__)
+#define LOG_WARNING_KV(...) Logger::getInstance()->logKV(std::source_location::current(), Logger::Level::WARNING, __VA_ARGS__)
+#define LOG_ERROR_KV(...) Logger::getInstance()->logKV(std::source_location::current(), Logger::Level::ERROR, __VA_ARGS__)
+#define LOG_FATAL_KV(...) Logger::getInstance()->logKV(std::source_location::current(), Logger::Level::FATAL, __VA_ARGS__)
+
+// helper macros for rate limited logging, each call site keeps its own static limiter state
+#define LOG_LIMITED_IMPL(level, check, ...)                                                               \
+    do                                                                                                    \
+    {                                                                                                     \
+        static Logger::CallSiteLimiter blitzLimiter_;                                                     \
+        auto *blitzLogger_ = Logger::getInstance();                                                       \
+        if (blitzLogger_->isLevelEnabled(level) && blitzLimiter_.check)                                   \
+            blitzLogger_->logLimited(blitzLimiter_, std::source_location::current(), level, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_TRACE_EVERY_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::TRACE, everyN(n), __VA_ARGS__)
+#define LOG_DEBUG_EVERY_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::DEBUG, everyN(n), __VA_ARGS__)
+#define LOG_INFO_EVERY_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::INFO, everyN(n), __VA_ARGS__)
+#define LOG_WARNING_EVERY_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::WARNING, everyN(n), __VA_ARGS__)
+#define LOG_ERROR_EVERY_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::ERROR, everyN(n), __VA_ARGS__)
+#define LOG_FATAL_EVERY_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::FATAL, everyN(n), __VA_ARGS__)
+
+#define LOG_TRACE_FIRST_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::TRACE, firstN(n), __VA_ARGS__)
+#define LOG_DEBUG_FIRST_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::DEBUG, firstN(n), __VA_ARGS__)
+#define LOG_INFO_FIRST_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::INFO, firstN(n), __VA_ARGS__)
+#define LOG_WARNING_FIRST_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::WARNING, firstN(n), __VA_ARGS__)
+#define LOG_ERROR_FIRST_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::ERROR, firstN(n), __VA_ARGS__)
+#define LOG_FATAL_FIRST_N(n, ...) LOG_LIMITED_IMPL(Logger::Level::FATAL, firstN(n), __VA_ARGS__)
+
+#define LOG_TRACE_EVERY_MS(ms, ...) LOG_LIMITED_IMPL(Logger::Level::TRACE, everyMs(ms), __VA_ARGS__)
+#define LOG_DEBUG_EVERY_MS(ms, ...) LOG_LIMITED_IMPL(Logger::Level::DEBUG, everyMs(ms), __VA_ARGS__)
+#define LOG_INFO_EVERY_MS(ms, ...) LOG_LIMITED_IMPL(Logger::Level::INFO, everyMs(ms), __VA_ARGS__)
+#define LOG_WARNING_EVERY_MS(ms, ...) LOG_LIMITED_IMPL(Logger::Level::WARNING, everyMs(ms), __VA_ARGS__)
+#define LOG_ERROR_EVERY_MS(ms, ...) LOG_LIMITED_IMPL(Logger::Level::ERROR, everyMs(ms), __VA_ARGS__)
+#define LOG_FATAL_EVERY_MS(ms, ...) LOG_LIMITED_IMPL(Logger::Level::FATAL, everyMs(ms), __VA_ARGS__)
+
+#define LOG_TRACE_RATE_LIMITED(perSec, burst, ...) LOG_LIMITED_IMPL(Logger::Level::TRACE, rateLimited(perSec, burst), __VA_ARGS__)
+#define LOG_DEBUG_RATE_LIMITED(perSec, burst, ...) LOG_LIMITED_IMPL(Logger::Level::DEBUG, rateLimited(perSec, burst), __VA_ARGS__)
+#define LOG_INFO_RATE_LIMITED(perSec, burst, ...) LOG_LIMITED_IMPL(Logger::Level::INFO, rateLimited(perSec, burst), __VA_ARGS__)
+#define LOG_WARNING_RATE_LIMITED(perSec, burst, ...) LOG_LIMITED_IMPL(Logger::Level::WARNING, rateLimited(perSec, burst), __VA_ARGS__)
+#define LOG_ERROR_RATE_LIMITED(perSec, burst, ...) LOG_LIMITED_IMPL(Logger::Level::ERROR, rateLimited(perSec, burst), __VA_ARGS__)
+#define LOG_FATAL_RATE_LIMITED(perSec, burst, ...) LOG_LIMITED_IMPL(Logger::Level::FATAL, rateLimited(perSec, burst), __VA_ARGS__)
@@ -0,0 +1,145 @@
+#include "blitz_numa.hpp"
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <sys/mman.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace blitz_numa
+{
+    namespace
+    {
+        constexpr int MPOL_PREFERRED_MODE = 1; // MPOL_PREFERRED from <numaif.h>
+
+        // sysfs list format, e.g. "0-3,8-11"
+        std::vector<int> readList(const std::string &path)
+        {
+            std::vector<int> items;
+            std::ifstream file(path);
+            std::string list;
+            if (!std::getline(file, list))
+                return items;
+
+            std::stringstream ranges(list);
+            for (std::string range; std::getline(ranges, range, ',');)
+            {
+                try
+                {
+                    auto dash = range.find('-');
+                    int first = std::stoi(range.substr(0, dash));
+                    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (int i = first; i <= last; ++i)
+                        items.push_back(i);
+                }
+                catch (const std::exception &)
+                {
+                    // not a number, skip the range
+                }
+            }
+            return items;
+        }
+    }
+
+    int nodeCount()
+    {
+#ifdef __linux__
+        static const int count = []()
+        {
+            auto nodes = readList("/sys/devices/system/node/online");
+            return nodes.empty() ? 1 : nodes.back() + 1;
+        }();
+        return count;
+#else
+        return 1;
+#endif
+    }
+
+    int currentNode() noexcept
+    {
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+            return static_cast<int>(node);
+#endif
+        return 0;
+    }
+
+    std::vector<int> nodeCpus(int node)
+    {
+#ifdef __linux__
+        if (node >= 0)
+            return readList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+#else
+        (void)node;
+#endif
+        return {};
+    }
+
+    void *map(size_t bytes, int node) noexcept
+    {
+        void *memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            return nullptr;
+
+        // before anything touches the pages, so they never start out on a remote node
+        if (node >= 0)
+            preferNode(memory, bytes, node);
+        return memory;
+    }
+
+    void unmap(void *memory, size_t bytes) noexcept
+    {
+        if (memory)
+            ::munmap(memory, bytes);
+    }
+
+    bool preferNode(void *memory, size_t bytes, int node) noexcept
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (node < 0 || node >= nodeCount() || nodeCount() < 2)
+            return false;
+
+        constexpr size_t BITS = sizeof(unsigned long) * 8;
+        unsigned long mask[8]{};
+        if (static_cast<size_t>(node) >= BITS * std::size(mask))
+            return false;
+        mask[node / BITS] |= 1UL << (node % BITS);
+        return ::syscall(SYS_mbind, memory, bytes, MPOL_PREFERRED_MODE, mask, BITS * std::size(mask) + 1, 0) == 0;
+#else
+        (void)memory;
+        (void)bytes;
+        (void)node;
+        return false;
+#endif
+    }
+
+    bool runOnNode(int node)
+    {
+#ifdef __linux__
+        auto cpus = nodeCpus(node);
+        if (cpus.empty())
+            return false;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            if (cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        }
+        return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)node;
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// NUMA topology and placement for the ring buffers and the logger thread, read from sysfs and set
+// with raw system calls so there is no libnuma dependency; everywhere but Linux there is one node
+namespace blitz_numa
+{
+    // nodes the system has online, 1 when NUMA is not available
+    int nodeCount();
+
+    // node of the CPU the calling thread is running on, 0 when unknown
+    int currentNode() noexcept;
+
+    // CPUs of a node, empty when the node does not exist
+    std::vector<int> nodeCpus(int node);
+
+    // map bytes of anonymous memory whose pages come from node once touched, any node for node < 0;
+    // nullptr on failure, release with unmap()
+    void *map(size_t bytes, int node) noexcept;
+    void unmap(void *memory, size_t bytes) noexcept;
+
+    // prefer node for the pages of a mapping that are not faulted in yet, false when not supported
+    bool preferNode(void *memory, size_t bytes, int node) noexcept;
+
+    // restrict the calling thread to the CPUs of node, false when the node is unknown or the call failed
+    bool runOnNode(int node);
+}
@@ -0,0 +1,88 @@
+#include "blitz_thread.hpp"
+#include <cerrno>
+#include <cstring>
+#include <format>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace blitz_thread
+{
+    namespace
+    {
+        void addFailure(std::string &failures, std::string_view setting, int error)
+        {
+            if (!failures.empty())
+                failures += ", ";
+            failures += std::format("{}: {}", setting, std::strerror(error));
+        }
+    }
+
+    std::string apply(const Options &options)
+    {
+        std::string failures;
+#ifdef __linux__
+        if (!options.name.empty())
+        {
+            if (int error = ::pthread_setname_np(::pthread_self(), options.name.substr(0, 15).c_str()))
+                addFailure(failures, "name", error);
+        }
+
+        if (!options.cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : options.cpus)
+            {
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                    CPU_SET(cpu, &set);
+            }
+            if (int error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set))
+                addFailure(failures, "cpus", error);
+        }
+
+        // policy before nice, the nice value only means something for the time sharing policies
+        if (options.policy != Policy::INHERIT)
+        {
+            int policy = SCHED_OTHER;
+            switch (options.policy)
+            {
+            case Policy::BATCH:
+                policy = SCHED_BATCH;
+                break;
+            case Policy::IDLE:
+                policy = SCHED_IDLE;
+                break;
+            case Policy::FIFO:
+                policy = SCHED_FIFO;
+                break;
+            case Policy::RR:
+                policy = SCHED_RR;
+                break;
+            default:
+                break;
+            }
+
+            sched_param param{};
+            param.sched_priority = policy == SCHED_FIFO || policy == SCHED_RR ? options.priority : 0;
+            if (int error = ::pthread_setschedparam(::pthread_self(), policy, &param))
+                addFailure(failures, "policy", error);
+        }
+
+        if (options.nice)
+        {
+            if (::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), *options.nice) != 0)
+                addFailure(failures, "nice", errno);
+        }
+#else
+        if (!options.name.empty() || !options.cpus.empty() || options.nice || options.policy != Policy::INHERIT)
+            failures = "thread options are only supported on Linux";
+#endif
+        return failures;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// name, CPU placement and scheduling of the logger's background threads, so they can be told apart
+// in top -H and kept off cores isolated for latency critical work
+namespace blitz_thread
+{
+    enum class Policy
+    {
+        INHERIT, // keep the creating thread's policy
+        OTHER,   // SCHED_OTHER, the default time sharing policy
+        BATCH,   // SCHED_BATCH, throughput work that may be preempted at will
+        IDLE,    // SCHED_IDLE, runs only when nothing else wants the CPU
+        FIFO,    // SCHED_FIFO, real time with priority
+        RR       // SCHED_RR, real time with priority and time slices
+    };
+
+    struct Options
+    {
+        std::string name{};       // shown by top -H and ps -L, cut to 15 characters
+        std::vector<int> cpus{};  // CPUs the thread may run on, empty keeps the inherited set
+        std::optional<int> nice{}; // nice value, -20 to 19, unset keeps the inherited one
+        Policy policy{Policy::INHERIT};
+        int priority{0};          // 1 to 99 for FIFO and RR, ignored otherwise
+    };
+
+    // applies options to the calling thread, best effort: returns what could not be applied and
+    // why, empty when everything was; raising the priority usually needs CAP_SYS_NICE
+    std::string apply(const Options &options);
+}
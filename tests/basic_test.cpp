@@ -1,4 +1,9 @@
 #include "blitz_logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <optional>
 #include <random>
 
 // unified configuration
@@ -18,6 +23,9 @@ Logger::Config getTestConfig()
     config.showSourceLocation = true;
     config.showModuleName = true;
     config.showFullPath = true;
+    config.deduplicateMessages = true;
+    config.dedupWindowMs = 200;
+    config.sanitizeMessages = true;
     return config;
 }
 
@@ -52,6 +60,7 @@ void testFormatting()
 
     // complex formatting
     LOG_INFO("Test special characters: \\n, \\t, \\r");
+    LOG_INFO("Sanitized control characters: first line\nsecond line\ttab \x1b[0m C:\\temp");
     LOG_INFO("Right aligned: |{:>10}|", "right");
     LOG_INFO("Hexadecimal: 0x{:X}", 255);
     LOG_INFO("Scientific: {:.2e}", 12345.6789);
@@ -74,12 +83,368 @@ void testErrorHandling()
     }
 }
 
+// test rate limited logging
+void testRateLimiting()
+{
+    Logger::getInstance()->setModuleName("RateLimiting");
+    LOG_STEP(4, "=== Testing Rate Limiting ===");
+
+    for (int i = 0; i < 10; ++i)
+    {
+        LOG_INFO_EVERY_N(4, "Every 4th iteration: {}", i);
+        LOG_INFO_FIRST_N(2, "First 2 iterations only: {}", i);
+        LOG_WARNING_EVERY_MS(1000, "At most once per second: {}", i);
+        LOG_ERROR_RATE_LIMITED(1.0, 3, "Token bucket (1/s, burst 3): {}", i);
+
+        // out of range arguments are clamped or rejected rather than overflowing
+        LOG_INFO_RATE_LIMITED(1e-12, 1, "Tiny rate: {}", i);
+        LOG_INFO_RATE_LIMITED(1.0, UINT64_MAX, "Huge burst: {}", i);
+        LOG_INFO_RATE_LIMITED(std::nan(""), 3, "NaN rate: {}", i);
+    }
+
+    LOG_INFO("RateLimiting test complete\n");
+}
+
+// test duplicate suppression
+void testDeduplication()
+{
+    Logger::getInstance()->setModuleName("Deduplication");
+    LOG_STEP(5, "=== Testing Deduplication ===");
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        LOG_ERROR("Connection to {} refused", "db-primary:5432");
+    }
+
+    // let the window expire so the repeat summary is emitted
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    LOG_INFO("Deduplication test complete\n");
+}
+
+void logStructured()
+{
+    LOG_INFO_KV("request done", "latency_us", 1250, "status", 200, "cached", false);
+    LOG_WARNING_KV("slow query", "table", "users", "rows", 10'000u, "seconds", 2.5);
+    LOG_ERROR_KV("quoted value", "reason", "connection \"reset\" by peer\n\x01");
+}
+
+// the structured layouts write to their own files, named after the layout
+Logger::Config structuredConfig(const Logger::Config &config, Logger::Layout layout, std::string_view name)
+{
+    auto structured = config;
+    structured.layout = layout;
+    structured.filePrefix = std::format("{}_{}", config.filePrefix, name);
+    structured.consoleOutput = false;
+    structured.deduplicateMessages = false; // the same call sites log again within the window
+    return structured;
+}
+
+// test structured key-value logging
+void testStructuredLogging(const Logger::Config &config)
+{
+    Logger::getInstance()->setModuleName("Structured");
+    LOG_STEP(6, "=== Testing Structured Logging ===");
+
+    logStructured();
+
+    // switch layouts only once everything logged so far is out
+    for (auto [layout, name] : {std::pair{Logger::Layout::JSON, "json"}, std::pair{Logger::Layout::LOGFMT, "logfmt"}})
+    {
+        auto structured = structuredConfig(config, layout, name);
+        std::filesystem::remove(std::format("{}/{}.log", structured.logDir, structured.filePrefix));
+        Logger::getInstance()->flush();
+        Logger::getInstance()->configure(structured);
+        logStructured();
+        Logger::getInstance()->flush();
+    }
+    Logger::getInstance()->configure(config);
+
+    LOG_INFO("Structured test complete\n");
+}
+
+// the whole log file, one entry per line
+std::vector<std::string> readLogLines(const Logger::Config &config)
+{
+    std::ifstream file(std::format("{}/{}.log", config.logDir, config.filePrefix));
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);)
+        lines.push_back(std::move(line));
+    return lines;
+}
+
+// control characters and backslashes are escaped, so the message stays on one line and can be unescaped
+bool verifySanitized(const std::vector<std::string> &lines)
+{
+    const std::string expected = "Sanitized control characters: first line\\nsecond line\\ttab \\x1b[0m C:\\\\temp";
+    for (const auto &line : lines)
+    {
+        if (line.find("Sanitized control characters:") != std::string::npos)
+        {
+            if (line.ends_with(expected))
+                return true;
+            std::cout << std::format("[WARNING] sanitized line: {}\n", line);
+            return false;
+        }
+    }
+    std::cout << "[WARNING] sanitized line missing\n";
+    return false;
+}
+
+size_t countLines(const std::vector<std::string> &lines, std::string_view needle)
+{
+    return static_cast<size_t>(std::count_if(lines.begin(), lines.end(), [&](const std::string &line)
+                                             { return line.find(needle) != std::string::npos; }));
+}
+
+// reads a quoted, JSON escaped string starting at pos and moves pos past it
+std::optional<std::string> readQuoted(std::string_view line, size_t &pos)
+{
+    if (pos >= line.size() || line[pos] != '"')
+        return std::nullopt;
+
+    std::string value;
+    for (++pos; pos < line.size(); ++pos)
+    {
+        char c = line[pos];
+        if (c == '"')
+        {
+            ++pos;
+            return value;
+        }
+        if (static_cast<unsigned char>(c) < 0x20)
+            return std::nullopt; // control characters have to be escaped
+        if (c != '\\')
+        {
+            value.push_back(c);
+            continue;
+        }
+        if (++pos >= line.size())
+            return std::nullopt;
+        switch (line[pos])
+        {
+        case 'n':
+            value.push_back('\n');
+            break;
+        case 't':
+            value.push_back('\t');
+            break;
+        case 'r':
+            value.push_back('\r');
+            break;
+        case 'u':
+            if (pos + 4 >= line.size())
+                return std::nullopt;
+            value.push_back(static_cast<char>(std::stoi(std::string(line.substr(pos + 1, 4)), nullptr, 16)));
+            pos += 4;
+            break;
+        default:
+            value.push_back(line[pos]);
+            break;
+        }
+    }
+    return std::nullopt;
+}
+
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+// key=value pairs separated by spaces, quoted values unescaped
+std::optional<Fields> parseLogfmt(std::string_view line)
+{
+    Fields fields;
+    size_t pos = 0;
+    while (pos < line.size())
+    {
+        if (line[pos] == ' ')
+        {
+            ++pos;
+            continue;
+        }
+        size_t equals = line.find('=', pos);
+        if (equals == std::string_view::npos)
+            return std::nullopt;
+        std::string key(line.substr(pos, equals - pos));
+        pos = equals + 1;
+
+        if (pos < line.size() && line[pos] == '"')
+        {
+            auto value = readQuoted(line, pos);
+            if (!value)
+                return std::nullopt;
+            fields.emplace_back(std::move(key), std::move(*value));
+        }
+        else
+        {
+            size_t end = std::min(line.find(' ', pos), line.size());
+            fields.emplace_back(std::move(key), std::string(line.substr(pos, end - pos)));
+            pos = end;
+        }
+    }
+    return fields;
+}
+
+// members of a flat JSON object, string values unescaped and others as written
+std::optional<Fields> parseJson(std::string_view line)
+{
+    if (!line.starts_with('{') || !line.ends_with('}'))
+        return std::nullopt;
+
+    Fields fields;
+    size_t pos = 1;
+    while (pos < line.size() - 1)
+    {
+        auto key = readQuoted(line, pos);
+        if (!key || pos >= line.size() || line[pos++] != ':')
+            return std::nullopt;
+
+        std::optional<std::string> value;
+        if (line[pos] == '"')
+        {
+            value = readQuoted(line, pos);
+        }
+        else
+        {
+            size_t end = line.find_first_of(",}", pos);
+            value = std::string(line.substr(pos, end - pos));
+            pos = end;
+        }
+        if (!value)
+            return std::nullopt;
+        fields.emplace_back(std::move(*key), std::move(*value));
+
+        if (line[pos] == ',')
+            ++pos;
+    }
+    return fields;
+}
+
+// the fields logStructured() attaches to each message, in order
+const std::pair<std::string_view, Fields> STRUCTURED_RECORDS[] = {
+    {"request done", {{"latency_us", "1250"}, {"status", "200"}, {"cached", "false"}}},
+    {"slow query", {{"table", "users"}, {"rows", "10000"}, {"seconds", "2.5"}}},
+    {"quoted value", {{"reason", "connection \"reset\" by peer\n\x01"}}},
+};
+
+// parses every record logStructured() wrote in one layout and compares its fields
+bool verifyStructured(std::string_view layout, const std::vector<std::string> &lines,
+                      const std::function<std::optional<Fields>(const std::string &, std::string_view)> &fieldsOf)
+{
+    bool ok = true;
+    for (const auto &[message, expected] : STRUCTURED_RECORDS)
+    {
+        std::optional<Fields> fields;
+        for (const auto &line : lines)
+        {
+            if ((fields = fieldsOf(line, message)))
+                break;
+        }
+        if (fields != expected)
+        {
+            std::cout << std::format("[WARNING] {} fields of '{}' missing or wrong\n", layout, message);
+            ok = false;
+        }
+    }
+
+    // the raw line carries the escaped forms, not the characters themselves
+    if (countLines(lines, R"(connection \"reset\" by peer\n\u0001")") != 1)
+    {
+        std::cout << std::format("[WARNING] {} value with quotes and control characters not escaped\n", layout);
+        ok = false;
+    }
+    return ok;
+}
+
+// the fields following the message, in the text layout and in both structured ones
+bool verifyStructuredLogging(const Logger::Config &config, const std::vector<std::string> &lines)
+{
+    auto afterMessage = [](const std::string &line, std::string_view message) -> std::optional<Fields>
+    {
+        auto pos = line.find(message);
+        if (pos == std::string::npos || (pos + message.size() < line.size() && line[pos + message.size()] != ' '))
+            return std::nullopt;
+        return parseLogfmt(std::string_view(line).substr(pos + message.size()));
+    };
+
+    // the fields come after "msg", which is the last member before them in both layouts
+    auto afterMsg = [](std::optional<Fields> fields, std::string_view message) -> std::optional<Fields>
+    {
+        if (!fields)
+            return std::nullopt;
+        auto msg = std::find_if(fields->begin(), fields->end(), [](const auto &field)
+                                { return field.first == "msg"; });
+        if (msg == fields->end() || msg->second != message)
+            return std::nullopt;
+        return Fields(std::next(msg), fields->end());
+    };
+
+    bool ok = verifyStructured("text", lines, afterMessage);
+    ok = verifyStructured("JSON", readLogLines(structuredConfig(config, Logger::Layout::JSON, "json")),
+                          [&](const std::string &line, std::string_view message)
+                          { return afterMsg(parseJson(line), message); }) &&
+         ok;
+    ok = verifyStructured("logfmt", readLogLines(structuredConfig(config, Logger::Layout::LOGFMT, "logfmt")),
+                          [&](const std::string &line, std::string_view message)
+                          { return afterMsg(parseLogfmt(line), message); }) &&
+         ok;
+    return ok;
+}
+
+// 10 iterations through each limited call site, well inside one second
+bool verifyRateLimiting(const std::vector<std::string> &lines)
+{
+    const std::pair<std::string_view, size_t> expected[] = {
+        {"Every 4th iteration:", 3}, // i = 0, 4, 8
+        {"First 2 iterations only:", 2},
+        {"At most once per second:", 1},
+        {"Token bucket (1/s, burst 3):", 3},
+        {"Tiny rate:", 1},
+        {"Huge burst:", 10},
+        {"NaN rate:", 0},
+    };
+
+    bool ok = true;
+    for (const auto &[needle, count] : expected)
+    {
+        size_t seen = countLines(lines, needle);
+        if (seen != count)
+        {
+            std::cout << std::format("[WARNING] '{}' logged {} times, expected {}\n", needle, seen, count);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// 1000 identical errors collapse into the first occurrence and one repeat summary
+bool verifyDeduplication(const std::vector<std::string> &lines)
+{
+    const std::string_view message = "Connection to db-primary:5432 refused";
+    const std::string_view summary = "Message repeated 999 times: Connection to db-primary:5432 refused";
+
+    size_t total = countLines(lines, message);
+    size_t summaries = countLines(lines, summary);
+    if (total != 2 || summaries != 1)
+    {
+        std::cout << std::format("[WARNING] dedup wrote {} lines with {} expected summaries\n", total, summaries);
+        return false;
+    }
+
+    auto first = std::find_if(lines.begin(), lines.end(), [&](const std::string &line)
+                              { return line.find(message) != std::string::npos; });
+    if (first->find(summary) != std::string::npos)
+    {
+        std::cout << "[WARNING] dedup summary written before the first occurrence\n";
+        return false;
+    }
+    return true;
+}
+
 auto main(void) -> int
 {
     try
     {
         // initialize logger
         auto config = getTestConfig();
+        std::filesystem::remove(std::format("{}/{}.log", config.logDir, config.filePrefix));
         Logger::initialize(config);
 
         Logger::getInstance()->setModuleName("BasicTest");
@@ -93,12 +458,26 @@ auto main(void) -> int
 
         testErrorHandling();
 
+        testRateLimiting();
+
+        testDeduplication();
+
+        testStructuredLogging(config);
+
         Logger::getInstance()->setModuleName("Congratulations");
         LOG_INFO("All tests completed successfully");
 
         // cleanup
         Logger::destroyInstance();
-        return EXIT_SUCCESS;
+
+        const auto lines = readLogLines(config);
+        bool passed = verifySanitized(lines);
+        passed = verifyRateLimiting(lines) && passed;
+        passed = verifyDeduplication(lines) && passed;
+        passed = verifyStructuredLogging(config, lines) && passed;
+
+        std::cout << std::format("[RESULT] Basic: {}\n", passed ? "PASSED" : "FAILED");
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
     }
     catch (const std::exception &e)
     {
@@ -0,0 +1,139 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    // a record written before structured fields existed, the reader must not look for them
+    bool decodesVersion1()
+    {
+        std::string file(blitz_binary::MAGIC.begin(), blitz_binary::MAGIC.end());
+        file.push_back(1);
+        blitz_binary::putVarint(file, 1000);
+        file.push_back(static_cast<char>(blitz_binary::Tag::CALL_SITE));
+        blitz_binary::putVarint(file, 0);
+        file.push_back(static_cast<char>(Logger::Level::INFO));
+        blitz_binary::putVarint(file, 12);
+        blitz_binary::putString(file, "old.cpp");
+        blitz_binary::putString(file, "main");
+        blitz_binary::putString(file, "Old record {}");
+        file.push_back(static_cast<char>(blitz_binary::Tag::MODULE));
+        blitz_binary::putVarint(file, 0);
+        blitz_binary::putString(file, "Legacy");
+        file.push_back(static_cast<char>(blitz_binary::Tag::THREAD));
+        blitz_binary::putVarint(file, 0);
+        blitz_binary::putVarint(file, 42);
+        for (int i = 0; i < 2; ++i)
+        {
+            std::string args;
+            blitz_binary::encodeArgs(args, i);
+            file.push_back(static_cast<char>(blitz_binary::Tag::MESSAGE));
+            blitz_binary::putVarint(file, 0);
+            blitz_binary::putVarint(file, 0);
+            blitz_binary::putVarint(file, 0);
+            blitz_binary::putVarint(file, blitz_binary::zigzag(5));
+            blitz_binary::putString(file, args);
+        }
+
+        std::istringstream input(file);
+        blitz_binary::Reader reader(input);
+        blitz_binary::DecodedMessage msg;
+        try
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                if (!reader.next(msg) || msg.message != std::format("Old record {}", i) || !msg.fields.empty() ||
+                    msg.module != "Legacy" || msg.timestampNs != 1000 + 5 * (i + 1))
+                {
+                    std::cout << std::format("[WARNING] Version 1 record {} decoded as '{}'\n", i, msg.message);
+                    return false;
+                }
+            }
+            return !reader.next(msg);
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << std::format("[ERROR] Decoding version 1 failed: {}\n", e.what());
+            return false;
+        }
+    }
+}
+
+// logs a set of messages with binary output and checks that decoding reproduces std::format
+auto main(void) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "test_logs";
+    cfg.filePrefix = "binary_test";
+    cfg.minLevel = Logger::Level::TRACE;
+    cfg.consoleOutput = false;
+    cfg.fileOutput = true;
+    cfg.binaryOutput = true;
+
+    std::filesystem::remove(std::format("{}/{}.blz", cfg.logDir, cfg.filePrefix));
+    Logger::initialize(cfg);
+
+    std::vector<std::string> expected = {"Logger initialized with thread-local buffers"};
+    auto check = [&expected](std::string text)
+    { expected.push_back(std::move(text)); };
+
+    Logger::getInstance()->setModuleName("BinaryTest");
+    const std::string name = "blitz";
+    const std::string_view view = "view";
+    for (int i = 0; i < 1000; ++i)
+    {
+        LOG_INFO("Integer: {} negative: {} unsigned: {}", i, -i, static_cast<unsigned>(i) * 7u);
+        check(std::format("Integer: {} negative: {} unsigned: {}", i, -i, static_cast<unsigned>(i) * 7u));
+    }
+    LOG_DEBUG("Float: {:.3f} double: {} scientific: {:.2e}", 1.5f, 0.1, 12345.6789);
+    check(std::format("Float: {:.3f} double: {} scientific: {:.2e}", 1.5f, 0.1, 12345.6789));
+    LOG_WARNING("Strings: {} {} {} char: {} bool: {}", name, view, "literal", 'x', true);
+    check(std::format("Strings: {} {} {} char: {} bool: {}", name, view, "literal", 'x', true));
+    LOG_ERROR("Aligned: |{:>10}| hex: 0x{:X} braces: {{}}", "right", 255);
+    check(std::format("Aligned: |{:>10}| hex: 0x{:X} braces: {{}}", "right", 255));
+    LOG_ERROR("Indexed: {1} {0} {1}", "first", "second");
+    check(std::format("Indexed: {1} {0} {1}", "first", "second"));
+    LOG_INFO("Dynamic width: |{:{}}|", 42, 6);
+    check(std::format("Dynamic width: |{:{}}|", 42, 6));
+    LOG_STEP(1, "Step with {}", "arguments");
+    check(std::format("[Step {}] {}", 1, std::format("Step with {}", "arguments")));
+    LOG_INFO("Pointer falls back to text: {}", static_cast<const void *>(nullptr));
+    check(std::format("Pointer falls back to text: {}", static_cast<const void *>(nullptr)));
+
+    Logger::destroyInstance();
+
+    std::ifstream input(std::format("{}/{}.blz", cfg.logDir, cfg.filePrefix), std::ios::binary);
+    blitz_binary::Reader reader(input);
+    blitz_binary::DecodedMessage msg;
+    size_t index = 0;
+    bool passed = true;
+
+    try
+    {
+        while (reader.next(msg))
+        {
+            if (index >= expected.size() || msg.message != expected[index])
+            {
+                std::cout << std::format("[WARNING] Mismatch at {}: '{}' != '{}'\n",
+                                         index, msg.message, index < expected.size() ? expected[index] : "");
+                passed = false;
+            }
+            ++index;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::format("[ERROR] Decoding failed: {}\n", e.what());
+        passed = false;
+    }
+
+    if (index != expected.size())
+        passed = false;
+
+    std::cout << std::format("[INFO] Messages decoded: {}/{}\n", index, expected.size());
+    std::cout << std::format("[RESULT] Binary round trip: {}\n", passed ? "PASSED" : "FAILED");
+
+    const bool version1 = decodesVersion1();
+    std::cout << std::format("[RESULT] Version 1 records: {}\n", version1 ? "PASSED" : "FAILED");
+    return passed && version1 ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#include "blitz_logger.hpp"
+#include "blitz_numa.hpp"
+#include <fstream>
+#include <map>
+
+// per-thread ring capacities: an override before the first log, a switch to a new ring midway and
+// adaptive growth under load, then threads that exit right after logging and leave their rings to
+// the next ones; every message has to arrive exactly once and in order per thread
+namespace
+{
+    size_t ringCapacity(const Logger::Metrics &metrics, std::thread::id thread)
+    {
+        for (const auto &buffer : metrics.buffers)
+        {
+            if (buffer.threadHash == std::hash<std::thread::id>{}(thread))
+                return buffer.capacity + 1;
+        }
+        return 0;
+    }
+
+    // background threads show up under their configured names in /proc, as top -H lists them
+    bool threadNamed(const std::string &name)
+    {
+        std::error_code error;
+        for (const auto &task : std::filesystem::directory_iterator("/proc/self/task", error))
+        {
+            std::ifstream comm(task.path() / "comm");
+            std::string line;
+            if (std::getline(comm, line) && line == name)
+                return true;
+        }
+        return false;
+    }
+
+    // exited threads' rings leave the registry once the logger thread has emptied them
+    bool waitForRings(Logger &logger, size_t count)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (logger.metrics().buffers.size() > count)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // "Ordered <tag> <n>" lines, checks that each tag counts up from 0 without gaps
+    bool verifyOrder(const std::string &path, const std::map<std::string, int> &expected)
+    {
+        std::map<std::string, int> next;
+        std::ifstream file(path);
+        bool passed = true;
+        for (std::string line; std::getline(file, line);)
+        {
+            auto pos = line.find("Ordered ");
+            if (pos == std::string::npos)
+                continue;
+
+            std::istringstream fields(line.substr(pos + 8));
+            std::string tag;
+            int sequence = -1;
+            fields >> tag >> sequence;
+            if (sequence != next[tag]++)
+            {
+                std::cout << std::format("[WARNING] {}: expected {}, got {}\n", tag, next[tag] - 1, sequence);
+                passed = false;
+                next[tag] = sequence + 1;
+            }
+        }
+
+        for (const auto &[tag, count] : expected)
+        {
+            if (next[tag] != count)
+            {
+                std::cout << std::format("[WARNING] {}: {} of {} messages\n", tag, next[tag], count);
+                passed = false;
+            }
+        }
+        return passed;
+    }
+}
+
+auto main(void) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/buffer";
+    cfg.filePrefix = "buffer_test";
+    cfg.consoleOutput = false;
+    cfg.maxFileSize = 1024 * 1024 * 1024;
+    cfg.bufferCapacity = 1024;
+    cfg.maxBufferCapacity = 16384;
+    cfg.pooledBuffers = 8; // room for the replaced rings next to the ones the short-lived threads hand on
+    cfg.numaLocalBuffers = true;
+    cfg.loggerNumaNode = 0;
+    cfg.loggerThreadOptions.name = "buffer-logger";
+
+    std::filesystem::remove_all(cfg.logDir);
+    Logger::initialize(cfg);
+    auto logger = Logger::getInstance();
+    bool passed = true;
+
+    constexpr int SMALL_COUNT = 1000;
+    constexpr int SWITCH_COUNT = 5000;
+    constexpr int HOT_COUNT = 300000;
+    constexpr int CHURN_THREADS = 20;
+    constexpr int CHURN_COUNT = 500;
+
+    // threads stay alive until the checks are done, their rings go away with them
+    std::atomic<int> done{0};
+    std::atomic<bool> release{false};
+    auto wait = [&]()
+    {
+        done++;
+        while (!release.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+
+    std::thread small([&]()
+                      {
+        logger->setThreadBufferCapacity(64);
+        for (int i = 0; i < SMALL_COUNT; ++i)
+            LOG_INFO("Ordered small {}", i);
+        wait(); });
+
+    // 0 after the first log returns to the configured capacity
+    std::thread reset([&]()
+                      {
+        logger->setThreadBufferCapacity(64);
+        for (int i = 0; i < SMALL_COUNT; ++i)
+        {
+            LOG_INFO("Ordered reset {}", i);
+            if (i == SMALL_COUNT / 2)
+                logger->setThreadBufferCapacity(0);
+        }
+        wait(); });
+
+    std::thread hot([&]()
+                    {
+        for (int i = 0; i < HOT_COUNT; ++i)
+            LOG_INFO("Ordered hot {}", i);
+        wait(); });
+
+    // the main thread moves to a new ring with messages still queued in the old one
+    for (int i = 0; i < SWITCH_COUNT; ++i)
+    {
+        LOG_INFO("Ordered switch {}", i);
+        if (i == SWITCH_COUNT / 2)
+            logger->setThreadBufferCapacity(256);
+    }
+
+    while (done.load() < 3)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    passed = logger->flush(std::chrono::seconds(30)) && passed;
+
+    Logger::Metrics metrics = logger->metrics();
+    size_t smallCapacity = ringCapacity(metrics, small.get_id());
+    size_t switchCapacity = ringCapacity(metrics, std::this_thread::get_id());
+    size_t hotCapacity = ringCapacity(metrics, hot.get_id());
+    size_t resetCapacity = ringCapacity(metrics, reset.get_id());
+    std::cout << std::format("Ring capacities: small {}, switched {}, reset {}, hot {} after {} growths, {} blocked pushes\n",
+                             smallCapacity, switchCapacity, resetCapacity, hotCapacity, metrics.bufferGrowths, metrics.blockedPushes);
+
+    if (smallCapacity != 64 || switchCapacity != 256 || resetCapacity != cfg.bufferCapacity)
+    {
+        std::cout << "[WARNING] per-thread capacity not applied\n";
+        passed = false;
+    }
+    if (metrics.blockedPushes > 0 && (metrics.bufferGrowths == 0 || hotCapacity <= cfg.bufferCapacity))
+    {
+        std::cout << "[WARNING] ring of the blocked thread did not grow\n";
+        passed = false;
+    }
+    if (hotCapacity > cfg.maxBufferCapacity)
+    {
+        std::cout << "[WARNING] ring grew past maxBufferCapacity\n";
+        passed = false;
+    }
+#ifdef __linux__
+    if (!threadNamed("buffer-logger"))
+    {
+        std::cout << "[WARNING] logger thread not named\n";
+        passed = false;
+    }
+#endif
+    for (const auto &buffer : metrics.buffers)
+    {
+        if (buffer.numaNode < 0 || buffer.numaNode >= blitz_numa::nodeCount())
+        {
+            std::cout << std::format("[WARNING] ring of {:x} placed on node {}\n", buffer.threadHash, buffer.numaNode);
+            passed = false;
+        }
+    }
+
+    release = true;
+    small.join();
+    reset.join();
+    hot.join();
+    if (!waitForRings(*logger, 1))
+    {
+        std::cout << "[WARNING] rings of exited threads not retired\n";
+        passed = false;
+    }
+    // retired rings keep counting towards the totals, they are Prometheus counters
+    if (Logger::Metrics retired = logger->metrics();
+        retired.blockedPushes < metrics.blockedPushes || retired.yieldSpins < metrics.yieldSpins)
+    {
+        std::cout << std::format("[WARNING] blocked pushes went from {} to {} after retiring rings\n",
+                                 metrics.blockedPushes, retired.blockedPushes);
+        passed = false;
+    }
+
+    // each thread exits with its last messages still queued and hands its ring on
+    std::map<std::string, int> expected{{"small", SMALL_COUNT}, {"reset", SMALL_COUNT}, {"switch", SWITCH_COUNT}, {"hot", HOT_COUNT}};
+    const uint64_t reusedBefore = logger->metrics().buffersReused;
+    for (int t = 0; t < CHURN_THREADS; ++t)
+    {
+        std::thread([t]()
+                    {
+            for (int i = 0; i < CHURN_COUNT; ++i)
+                LOG_INFO("Ordered churn{} {}", t, i); })
+            .join();
+        passed = waitForRings(*logger, 1) && passed;
+        expected[std::format("churn{}", t)] = CHURN_COUNT;
+    }
+    passed = logger->flush(std::chrono::seconds(30)) && passed;
+
+    metrics = logger->metrics();
+    std::cout << std::format("Short-lived threads: {} rings retired, {} reused\n", metrics.buffersRetired,
+                             metrics.buffersReused - reusedBefore);
+    if (metrics.buffersReused - reusedBefore < CHURN_THREADS - 1)
+    {
+        std::cout << "[WARNING] rings of exited threads not reused\n";
+        passed = false;
+    }
+
+    passed = verifyOrder(std::format("{}/{}.log", cfg.logDir, cfg.filePrefix), expected) && passed;
+    Logger::destroyInstance();
+
+    std::cout << std::format("[RESULT] Buffer capacities: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
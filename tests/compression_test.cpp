@@ -0,0 +1,132 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+#include <iterator>
+#include <random>
+
+// checks codec round trips, then logs through several rotations and reads every message back
+// from the compressed rotated files
+namespace
+{
+    std::vector<std::shared_ptr<const blitz_compress::Codec>> codecs()
+    {
+        std::vector<std::shared_ptr<const blitz_compress::Codec>> result = {blitz_compress::makeLzCodec()};
+#ifdef BLITZ_WITH_ZLIB
+        result.push_back(blitz_compress::makeGzipCodec());
+#endif
+        return result;
+    }
+
+    bool testCodecRoundTrip()
+    {
+        std::mt19937 rng(42);
+        bool passed = true;
+
+        for (const auto &codec : codecs())
+        {
+            for (int round = 0; round < 200 && passed; ++round)
+            {
+                // mix of empty, tiny, random and highly repetitive inputs, several frames per stream
+                std::string input;
+                size_t size = round == 0 ? 0 : rng() % 20000;
+                char alphabet = static_cast<char>(1 + rng() % 64);
+                for (size_t i = 0; i < size; ++i)
+                    input += round % 2 ? static_cast<char>('a' + i % 7) : static_cast<char>('a' + rng() % alphabet);
+
+                std::vector<char> compressed;
+                codec->compressFrame(input, compressed);
+                codec->compressFrame(input, compressed);
+
+                std::vector<char> output;
+                codec->decompress(std::string_view(compressed.data(), compressed.size()), output);
+                if (std::string(output.begin(), output.end()) != input + input)
+                {
+                    std::cout << std::format("[WARNING] {} round trip mismatch for {} bytes\n", codec->name(), size);
+                    passed = false;
+                }
+            }
+
+            // corrupt input must throw instead of crashing
+            std::vector<char> compressed;
+            codec->compressFrame(std::string(1000, 'x'), compressed);
+            compressed.resize(compressed.size() / 2);
+            try
+            {
+                std::vector<char> output;
+                codec->decompress(std::string_view(compressed.data(), compressed.size()), output);
+                std::cout << std::format("[WARNING] {} accepted truncated input\n", codec->name());
+                passed = false;
+            }
+            catch (const std::runtime_error &)
+            {
+            }
+        }
+
+        std::cout << std::format("[RESULT] Codec round trip: {}\n", passed ? "PASSED" : "FAILED");
+        return passed;
+    }
+}
+
+auto main(void) -> int
+{
+    bool passed = testCodecRoundTrip();
+
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/compression";
+    cfg.filePrefix = "compression_test";
+    cfg.consoleOutput = false;
+    cfg.fileOutput = true;
+    cfg.maxFileSize = 256 * 1024;
+    cfg.maxFiles = 1000;
+    cfg.compressionCodec = blitz_compress::makeLzCodec();
+
+    std::filesystem::remove_all(cfg.logDir);
+    Logger::initialize(cfg);
+
+    constexpr int MESSAGE_COUNT = 50000;
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+        LOG_INFO("Compressed message {} with some repetitive payload to compress", i);
+    }
+
+    // joins the compression worker after it has finished the queue
+    Logger::destroyInstance();
+
+    size_t rotated = 0;
+    size_t compressedBytes = 0;
+    size_t rawBytes = 0;
+    std::vector<bool> seen(MESSAGE_COUNT, false);
+
+    for (const auto &entry : std::filesystem::directory_iterator(cfg.logDir))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.ends_with(".log") && name != "compression_test.log")
+        {
+            std::cout << std::format("[WARNING] Rotated file left uncompressed: {}\n", name);
+            passed = false;
+        }
+        if (name.ends_with(".log.lz"))
+            rotated++;
+
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::string raw(std::istreambuf_iterator<char>(file), {});
+        std::vector<char> data = blitz_compress::decompressAny(raw);
+        compressedBytes += raw.size();
+        rawBytes += data.size();
+
+        std::string_view text(data.data(), data.size());
+        for (size_t pos = text.find("Compressed message "); pos != std::string_view::npos;
+             pos = text.find("Compressed message ", pos + 1))
+        {
+            seen[std::stoul(std::string(text.substr(pos + 19, 8)))] = true;
+        }
+    }
+
+    size_t missing = static_cast<size_t>(std::count(seen.begin(), seen.end(), false));
+    if (rotated == 0 || missing != 0)
+        passed = false;
+
+    std::cout << std::format("Rotated files: {}, missing messages: {}, ratio {:.1f}:1\n",
+                             rotated, missing, static_cast<double>(rawBytes) / std::max<size_t>(compressedBytes, 1));
+    std::cout << std::format("[RESULT] Compressed rotation: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+
+// with flushIntervalMs set, output is held back until the interval passes or flushBytes are
+// pending, with syncOnError an ERROR batch goes out right away, and neither flushing nor
+// syncIntervalMs waits for a pending repeat summary
+namespace
+{
+    size_t countLines(const std::string &path, std::string_view needle)
+    {
+        size_t count = 0;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);)
+        {
+            if (line.find(needle) != std::string::npos)
+                count++;
+        }
+        return count;
+    }
+
+    // polls the file until count lines contain needle, returns how long that took or timeout
+    std::chrono::milliseconds waitForLines(const std::string &path, std::string_view needle, size_t count,
+                                           std::chrono::milliseconds timeout)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        while (countLines(path, needle) < count)
+        {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            if (elapsed >= timeout)
+                return timeout;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+}
+
+auto main(void) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/durability";
+    cfg.filePrefix = "durability_test";
+    cfg.consoleOutput = false;
+    cfg.flushIntervalMs = 2000;
+    cfg.flushBytes = 64 * 1024;
+    cfg.syncOnError = true;
+    cfg.syncIntervalMs = 500;
+    cfg.deduplicateMessages = true;
+    cfg.dedupWindowMs = 60000;
+
+    std::filesystem::remove_all(cfg.logDir);
+    Logger::initialize(cfg);
+    const std::string path = std::format("{}/{}.log", cfg.logDir, cfg.filePrefix);
+    const std::chrono::milliseconds interval(cfg.flushIntervalMs);
+    bool passed = true;
+
+    // start from an empty pending buffer, the startup message goes out once its interval passed
+    if (waitForLines(path, "Logger initialized", 1, 3 * interval) == 3 * interval)
+    {
+        std::cout << "[WARNING] startup message never written\n";
+        passed = false;
+    }
+
+    // interval: held back at first, written once the interval has passed
+    LOG_INFO("Held back probe");
+    std::this_thread::sleep_for(interval / 4);
+    if (countLines(path, "Held back probe") != 0)
+    {
+        std::cout << "[WARNING] output written before flushIntervalMs\n";
+        passed = false;
+    }
+    if (waitForLines(path, "Held back probe", 1, 3 * interval) == 3 * interval)
+    {
+        std::cout << "[WARNING] held back output not written after flushIntervalMs\n";
+        passed = false;
+    }
+
+    // bytes: more than flushBytes is written well before the interval
+    constexpr int BURST_COUNT = 2000; // about 200KB of lines
+    for (int i = 0; i < BURST_COUNT; ++i)
+        LOG_INFO("Burst message {} {}", i, std::string(40, 'x'));
+    auto burstWait = waitForLines(path, "Burst message", BURST_COUNT / 2, interval / 2);
+    if (burstWait == interval / 2)
+    {
+        std::cout << std::format("[WARNING] {} of {} burst lines written before flushIntervalMs\n",
+                                 countLines(path, "Burst message"), BURST_COUNT);
+        passed = false;
+    }
+
+    // syncOnError: the error and the output held back before it go out at once
+    LOG_ERROR("Error probe");
+    auto errorWait = waitForLines(path, "Error probe", 1, interval / 4);
+    if (errorWait == interval / 4 || countLines(path, "Burst message") != BURST_COUNT)
+    {
+        std::cout << "[WARNING] ERROR batch not written right away\n";
+        passed = false;
+    }
+
+    // dedup: with a repeat summary pending for the whole window, held back output is still
+    // written after the interval and then synced
+    for (int i = 0; i < 2; ++i)
+        LOG_WARNING("Repeated warning");
+    LOG_INFO("Pending summary probe");
+    const uint64_t syncsBefore = Logger::getInstance()->metrics().fileSyncs;
+    auto pendingWait = waitForLines(path, "Pending summary probe", 1, 3 * interval);
+    if (pendingWait == 3 * interval)
+    {
+        std::cout << "[WARNING] held back output not written while a repeat summary was pending\n";
+        passed = false;
+    }
+    std::this_thread::sleep_for(2 * std::chrono::milliseconds(cfg.syncIntervalMs));
+    if (Logger::getInstance()->metrics().fileSyncs == syncsBefore)
+    {
+        std::cout << "[WARNING] no periodic sync while a repeat summary was pending\n";
+        passed = false;
+    }
+
+    Logger::destroyInstance();
+
+    std::cout << std::format("Burst written after {} ms, error after {} ms, with a pending summary after {} ms (flushIntervalMs {})\n",
+                             burstWait.count(), errorWait.count(), pendingWait.count(), cfg.flushIntervalMs);
+    std::cout << std::format("[RESULT] Durability: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
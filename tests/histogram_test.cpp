@@ -0,0 +1,115 @@
+#include "blitz_logger.hpp"
+#include <random>
+
+// checks bucket boundaries and percentile precision of the latency histograms, then that every
+// message of an instrumented run shows up in the producer, queue and end to end stages
+namespace
+{
+    bool testBuckets()
+    {
+        std::mt19937_64 rng(42);
+        bool passed = true;
+
+        for (int i = 0; i < 1'000'000 && passed; ++i)
+        {
+            // spread over all magnitudes, including both ends of the range
+            uint64_t value = i == 0 ? 0 : i == 1 ? UINT64_MAX : rng() >> (rng() % 64);
+            size_t index = blitz_histogram::bucketIndex(value);
+            uint64_t low = blitz_histogram::bucketLow(index);
+            uint64_t high = blitz_histogram::bucketHigh(index);
+
+            if (index >= blitz_histogram::BUCKET_COUNT || value < low || value > high ||
+                static_cast<double>(high - low) > static_cast<double>(value) / blitz_histogram::SUB_BUCKETS)
+            {
+                std::cout << std::format("[WARNING] {} lands in bucket {} [{}, {}]\n", value, index, low, high);
+                passed = false;
+            }
+        }
+
+        blitz_histogram::Histogram histogram;
+        for (uint64_t value = 1; value <= 1'000'000; ++value)
+            histogram.record(value);
+
+        auto snapshot = histogram.snapshot();
+        for (double fraction : {0.5, 0.9, 0.99, 0.999})
+        {
+            double expected = fraction * 1'000'000;
+            double error = std::abs(static_cast<double>(snapshot.percentile(fraction)) - expected) / expected;
+            if (error > 1.0 / blitz_histogram::SUB_BUCKETS)
+            {
+                std::cout << std::format("[WARNING] p{} is {}, expected {}\n", fraction * 100, snapshot.percentile(fraction), expected);
+                passed = false;
+            }
+        }
+        if (snapshot.count != 1'000'000 || snapshot.min != 1 || snapshot.max != 1'000'000)
+            passed = false;
+
+        std::cout << std::format("[RESULT] Histogram buckets: {}\n", passed ? "PASSED" : "FAILED");
+        return passed;
+    }
+
+    uint64_t stageCount(const std::string &json, std::string_view stage)
+    {
+        auto pos = json.find(std::format("\"{}\":{{\"count\":", stage));
+        return pos == std::string::npos ? 0 : std::stoull(json.substr(pos + stage.size() + 12));
+    }
+}
+
+auto main(void) -> int
+{
+    bool passed = testBuckets();
+
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/histogram";
+    cfg.filePrefix = "histogram_test";
+    cfg.consoleOutput = false;
+    cfg.latencyHistograms = true;
+
+    std::filesystem::remove_all(cfg.logDir);
+    Logger::initialize(cfg);
+
+    // producers stay alive until the flush, their buffers leave the registry when they exit
+    constexpr int MESSAGE_COUNT = 50000;
+    std::atomic<int> logged{0};
+    std::atomic<bool> flushed{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            for (int i = 0; i < MESSAGE_COUNT; ++i)
+                LOG_INFO("Histogram thread {} message {}", t, i);
+            logged++;
+            while (!flushed.load())
+                std::this_thread::yield(); });
+    }
+    while (logged.load() < 2)
+        std::this_thread::yield();
+
+    auto logger = Logger::getInstance();
+    passed = logger->flush() && passed;
+    std::string json = logger->latencyHistogramsJson();
+    flushed = true;
+    for (auto &thread : threads)
+        thread.join();
+
+    uint64_t produced = stageCount(json, "producer");
+    uint64_t queued = stageCount(json, "queue");
+    uint64_t written = stageCount(json, "end_to_end");
+    if (produced < 2 * MESSAGE_COUNT || queued != produced || written != produced)
+    {
+        std::cout << std::format("[WARNING] {} messages produced, {} picked up, {} written\n", produced, queued, written);
+        passed = false;
+    }
+    if (stageCount(json, "format_batch") == 0 || stageCount(json, "write") == 0)
+    {
+        std::cout << "[WARNING] consumer stages were not recorded\n";
+        passed = false;
+    }
+
+    logger->printStats();
+    Logger::destroyInstance();
+
+    std::cout << std::format("[RESULT] Latency histograms: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
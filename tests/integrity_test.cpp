@@ -70,7 +70,9 @@ auto main(void) -> int
         .maxFileSize = 1'500'000'000, // 1.5 GB to ensure no rotation during test
         .minLevel = Logger::Level::INFO,
         .consoleOutput = false,
-        .fileOutput = true};
+        .fileOutput = true,
+        .bufferCapacity = 4096,     // wraps the ring thousands of times
+        .preallocatedBuffers = 1};  // ring comes from the arena
 
     Logger::initialize(cfg);
 
@@ -81,14 +83,17 @@ auto main(void) -> int
 
     Logger::getInstance()->printStats();
 
-    // destroy logger instance
-    Logger::destroyInstance();
+    // everything has to be in the file once flush() returns, while the logger keeps running
+    bool flushed = Logger::getInstance()->flush(std::chrono::seconds(60));
 
     // verify log integrity
     std::string logPath = std::format("{}/{}.log", cfg.logDir, cfg.filePrefix);
     std::cout << "\n[INFO] Verifying log integrity...\n";
 
-    bool integrityCheck = verifyLogIntegrity(logPath, MAX_COUNT);
+    bool integrityCheck = flushed && verifyLogIntegrity(logPath, MAX_COUNT);
+
+    // destroy logger instance
+    Logger::destroyInstance();
     std::cout << std::format("[RESULT] Integrity check: {}\n", integrityCheck ? "PASSED" : "FAILED");
 
     return integrityCheck ? 0 : 1;
@@ -0,0 +1,148 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+#include <iterator>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// logs through several rotations, then checks the metrics snapshot against the files on disk,
+// the HTTP endpoint and the Prometheus file left behind by the periodic export
+namespace
+{
+    // plain GET against "127.0.0.1:port", returns the whole response
+    std::string scrape(const std::string &endpoint, std::string_view path)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(std::stoi(endpoint.substr(endpoint.rfind(':') + 1))));
+        ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        std::string response;
+        if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0)
+        {
+            std::string request = std::format("GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+            (void)::send(fd, request.data(), request.size(), 0);
+
+            char chunk[4096];
+            for (ssize_t n; (n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0;)
+                response.append(chunk, static_cast<size_t>(n));
+        }
+        ::close(fd);
+        return response;
+    }
+}
+
+auto main(void) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/metrics";
+    cfg.filePrefix = "metrics_test";
+    cfg.consoleOutput = false;
+    cfg.maxFileSize = 256 * 1024;
+    cfg.maxFiles = 1000;
+    cfg.metricsFile = "test_logs/metrics/metrics.prom";
+    cfg.metricsInterval = std::chrono::seconds(1);
+    cfg.metricsEndpoint = "127.0.0.1:0";
+
+    std::filesystem::remove_all(cfg.logDir);
+
+    // an endpoint that cannot be bound only disables the server, the logger still starts and drains
+    Logger::Config unbindable = cfg;
+    unbindable.metricsEndpoint = "unix:/nonexistent/blitz_metrics.sock";
+    try
+    {
+        Logger::initialize(unbindable);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::format("[WARNING] failed metrics endpoint escaped initialize(): {}\n", e.what());
+        return EXIT_FAILURE;
+    }
+    LOG_INFO("Logged without a metrics endpoint");
+    bool passed = Logger::getInstance()->flush(std::chrono::seconds(5));
+    if (!passed || !Logger::getInstance()->metricsServerEndpoint().empty())
+    {
+        std::cout << "[WARNING] logger unusable after a failed metrics endpoint\n";
+        passed = false;
+    }
+    Logger::getInstance()->configure(cfg);
+
+    constexpr int MESSAGE_COUNT = 100000;
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+        LOG_INFO("Metrics message {}", i);
+    }
+
+    auto logger = Logger::getInstance();
+    passed = logger->flush() && passed;
+    Logger::Metrics metrics = logger->metrics();
+
+    // the staging file prepared for the next rotation is still empty, so everything adds up
+    uint64_t bytesOnDisk = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(cfg.logDir))
+    {
+        if (!entry.path().string().starts_with(cfg.metricsFile))
+            bytesOnDisk += entry.file_size();
+    }
+
+    auto self = std::find_if(metrics.buffers.begin(), metrics.buffers.end(), [](const Logger::BufferMetrics &buffer)
+                             { return buffer.threadHash == std::hash<std::thread::id>{}(std::this_thread::get_id()); });
+
+    if (metrics.messagesProduced < MESSAGE_COUNT || metrics.messagesConsumed != metrics.messagesProduced)
+    {
+        std::cout << std::format("[WARNING] {} messages produced, {} consumed\n", metrics.messagesProduced, metrics.messagesConsumed);
+        passed = false;
+    }
+    if (metrics.fileBytes != bytesOnDisk || metrics.writeErrors != 0)
+    {
+        std::cout << std::format("[WARNING] {} bytes counted, {} on disk\n", metrics.fileBytes, bytesOnDisk);
+        passed = false;
+    }
+    if (self == metrics.buffers.end() || self->highWaterMark == 0 || self->occupancy != 0)
+    {
+        std::cout << "[WARNING] buffer of the logging thread missing or inconsistent\n";
+        passed = false;
+    }
+    if (metrics.rotationNs.count == 0 || metrics.batchSizes.count == 0 ||
+        metrics.batchSizes.sum != metrics.messagesConsumed)
+    {
+        std::cout << std::format("[WARNING] {} rotations, {} batches\n", metrics.rotationNs.count, metrics.batchSizes.count);
+        passed = false;
+    }
+
+    std::cout << std::format("Rotations: {}, batches: {} (p50 {} messages), high water mark: {}, blocked pushes: {}\n",
+                             metrics.rotationNs.count, metrics.batchSizes.count, metrics.batchSizes.percentile(0.5),
+                             self != metrics.buffers.end() ? self->highWaterMark : 0, metrics.blockedPushes);
+
+    // nothing is logged meanwhile, so the endpoint reports the same counts
+    std::string endpoint = logger->metricsServerEndpoint();
+    std::string response = scrape(endpoint, "/metrics");
+    if (!response.starts_with("HTTP/1.1 200 OK\r\n") ||
+        response.find(std::format("blitz_messages_consumed_total {}\n", metrics.messagesConsumed)) == std::string::npos ||
+        response.find("blitz_consumer_lag_messages 0\n") == std::string::npos)
+    {
+        std::cout << std::format("[WARNING] unexpected response from {}:\n{}\n", endpoint, response.substr(0, 200));
+        passed = false;
+    }
+    if (!scrape(endpoint, "/other").starts_with("HTTP/1.1 404"))
+    {
+        std::cout << "[WARNING] unknown paths are not rejected\n";
+        passed = false;
+    }
+
+    // the export runs once more when the logger shuts down
+    Logger::destroyInstance();
+
+    std::ifstream file(cfg.metricsFile);
+    std::string exported(std::istreambuf_iterator<char>(file), {});
+    if (exported.find(std::format("blitz_messages_consumed_total {}\n", metrics.messagesConsumed)) == std::string::npos ||
+        exported.find("# TYPE blitz_buffer_high_water_mark gauge\n") == std::string::npos)
+    {
+        std::cout << "[WARNING] metrics file is missing or incomplete\n";
+        passed = false;
+    }
+
+    std::cout << std::format("[RESULT] Metrics: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
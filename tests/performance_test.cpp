@@ -87,7 +87,7 @@ void warm_up(Logger *logger)
     {
         LOG_INFO("warmup message #{}", i);
     }
-    std::this_thread::sleep_for(std::chrono::seconds(3));
+    logger->flush(std::chrono::seconds(30));
 }
 
 // cool down period
@@ -192,6 +192,66 @@ perf_stats perform_test(size_t message_count, size_t thread_count, size_t messag
     return stats;
 }
 
+// measure producer latency with and without the logger thread rotating the file every few milliseconds
+void perform_rotation_test()
+{
+    constexpr size_t message_count = 2'000'000;
+    constexpr auto rotation_period = std::chrono::milliseconds(10);
+
+    auto logger = Logger::getInstance();
+    std::string test_message = generate_message(128);
+
+    std::cout << "\n=== Rotation test ===" << std::endl;
+    std::cout << std::setw(15) << "Rotations"
+              << std::setw(15) << "P50 (μs)"
+              << std::setw(15) << "P99 (μs)"
+              << std::setw(15) << "P99.9 (μs)"
+              << std::setw(15) << "Max (μs)" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+
+    for (bool rotating : {false, true})
+    {
+        warm_up(logger);
+        logger->setModuleName("Rotation");
+
+        std::vector<double> latencies;
+        latencies.reserve(message_count);
+        std::atomic<bool> done{false};
+
+        std::thread producer([&]()
+                             {
+            for (size_t i = 0; i < message_count; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                LOG_INFO("Rotation - {} - {}", test_message, i);
+                auto end = std::chrono::steady_clock::now();
+                latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+            done.store(true); });
+
+        // force rotations while the producer runs
+        size_t rotations = 0;
+        while (!done.load())
+        {
+            std::this_thread::sleep_for(rotation_period);
+            if (rotating)
+            {
+                logger->rotate();
+                rotations++;
+            }
+        }
+        producer.join();
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(15) << rotations
+                  << std::setw(15) << calculate_percentile(latencies, 0.5)
+                  << std::setw(15) << calculate_percentile(latencies, 0.99)
+                  << std::setw(15) << calculate_percentile(latencies, 0.999)
+                  << std::setw(15) << *std::max_element(latencies.begin(), latencies.end()) << std::endl;
+
+        cool_down();
+    }
+}
+
 // print test results in table format
 void print_results(const std::vector<test_result> &results)
 {
@@ -255,6 +315,7 @@ auto main() -> int
         Logger::initialize(cfg);
 
         // run tests
+        perform_rotation_test();
         auto results = run_performance_tests();
         print_results(results);
 
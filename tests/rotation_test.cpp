@@ -0,0 +1,123 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+#include <iterator>
+#include <set>
+
+// rotates many times per second and on a time interval, then checks that no rotated file
+// was overwritten, every message is found exactly once and no staging file is left over
+auto main(void) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/rotation";
+    cfg.filePrefix = "rotation_test";
+    cfg.consoleOutput = false;
+    cfg.fileOutput = true;
+    cfg.maxFileSize = 64 * 1024;
+    cfg.maxFiles = 100000;
+    cfg.rotationPolicy = Logger::RotationPolicy::SIZE_OR_TIME;
+    cfg.rotationInterval = std::chrono::seconds(1);
+
+    std::filesystem::remove_all(cfg.logDir);
+
+    // staging files left behind by a crashed run: a prepared one that was never written is
+    // removed, one the crashed logger had swapped in keeps its records as a rotated file
+    std::filesystem::create_directories(cfg.logDir);
+    const std::string emptyStaging = "rotation_test.log.next.0badf00d.3";
+    const std::string crashRecord = "written before the crash";
+    std::ofstream(std::format("{}/{}", cfg.logDir, emptyStaging));
+    std::ofstream(std::format("{}/rotation_test.log.next.7", cfg.logDir)) << crashRecord << "\n";
+
+    // rotated by an earlier version, without a sequence, so numbering still starts at 1
+    const std::string legacyFile = "rotation_test_20240101_120000.log";
+    std::ofstream(std::format("{}/{}", cfg.logDir, legacyFile)) << "legacy\n";
+    // partial output of a compression the crash interrupted, the original is kept
+    std::ofstream(std::format("{}/{}.gz.tmp", cfg.logDir, legacyFile)) << "partial";
+
+    Logger::initialize(cfg);
+
+    // size based: dozens of rotations within the same second
+    constexpr int BURST_COUNT = 100000;
+    for (int i = 0; i < BURST_COUNT; ++i)
+    {
+        LOG_INFO("Rotated message {}", i);
+    }
+
+    // time based: a trickle of messages across several intervals
+    constexpr int TRICKLE_COUNT = 25;
+    for (int i = 0; i < TRICKLE_COUNT; ++i)
+    {
+        LOG_INFO("Rotated message {}", BURST_COUNT + i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    Logger::destroyInstance();
+
+    size_t rotated = 0;
+    size_t smallFiles = 0; // rotated by time rather than size
+    size_t crashRecords = 0;
+    std::set<std::string> sequences;
+    std::vector<int> seen(BURST_COUNT + TRICKLE_COUNT, 0);
+    bool passed = true;
+
+    for (const auto &entry : std::filesystem::directory_iterator(cfg.logDir))
+    {
+        std::string name = entry.path().filename().string();
+        if (!name.ends_with(".log"))
+        {
+            std::cout << std::format("[WARNING] Unexpected file: {}\n", name);
+            passed = false;
+            continue;
+        }
+
+        if (name == legacyFile)
+            continue;
+
+        bool recovered = false;
+        std::ifstream file(entry.path());
+        for (std::string line; std::getline(file, line);)
+        {
+            auto pos = line.find("Rotated message ");
+            if (pos != std::string::npos)
+                seen[std::stoi(line.substr(pos + 16))]++;
+            else if (line == crashRecord)
+                recovered = true;
+        }
+        crashRecords += recovered;
+
+        if (name != "rotation_test.log")
+        {
+            // rotation_test_<date>_<time>_<sequence>.log
+            rotated++;
+            sequences.insert(name.substr(name.rfind('_') + 1));
+            if (!recovered && entry.file_size() < cfg.maxFileSize)
+                smallFiles++;
+        }
+        else if (recovered)
+        {
+            std::cout << "[WARNING] crashed run's staging file became the active file\n";
+            passed = false;
+        }
+    }
+
+    if (crashRecords != 1)
+    {
+        std::cout << std::format("[WARNING] records of the crashed run's staging file found {} times\n", crashRecords);
+        passed = false;
+    }
+
+    size_t wrong = static_cast<size_t>(std::count_if(seen.begin(), seen.end(), [](int n)
+                                                     { return n != 1; }));
+    if (wrong != 0 || sequences.size() != rotated || smallFiles < 2)
+        passed = false;
+    if (!sequences.contains("000001.log"))
+    {
+        std::cout << std::format("[WARNING] numbering did not start at 1, first sequence: {}\n",
+                                 sequences.empty() ? "none" : *sequences.begin());
+        passed = false;
+    }
+
+    std::cout << std::format("Rotated files: {} ({} by time), unique sequences: {}, missing or duplicated messages: {}\n",
+                             rotated, smallFiles, sequences.size(), wrong);
+    std::cout << std::format("[RESULT] Rotation: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+
+// logs from several threads in synchronous mode and checks that every line is in the file as soon
+// as its call returns, without a logger thread or ring buffers
+namespace
+{
+    // over the active and rotated files
+    size_t countLines(const std::string &dir, std::string_view needle)
+    {
+        size_t count = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(dir))
+        {
+            std::ifstream file(entry.path());
+            for (std::string line; std::getline(file, line);)
+            {
+                if (line.find(needle) != std::string::npos)
+                    count++;
+            }
+        }
+        return count;
+    }
+}
+
+auto main(void) -> int
+{
+    Logger::Config cfg;
+    cfg.logDir = "test_logs/synchronous";
+    cfg.filePrefix = "synchronous_test";
+    cfg.consoleOutput = false;
+    cfg.maxFileSize = 2 * 1024 * 1024; // rotates a few times, on the logging threads
+    cfg.maxFiles = 1000;
+    cfg.preallocateFiles = false;
+    cfg.synchronous = true;
+
+    std::filesystem::remove_all(cfg.logDir);
+    Logger::initialize(cfg);
+    bool passed = true;
+
+    // written before the call returns, no flush needed
+    LOG_ERROR("Synchronous probe {}", 1);
+    if (countLines(cfg.logDir, "Synchronous probe 1") != 1)
+    {
+        std::cout << "[WARNING] message not in the file after the call returned\n";
+        passed = false;
+    }
+
+    constexpr int THREAD_COUNT = 4;
+    constexpr int MESSAGE_COUNT = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t)
+    {
+        threads.emplace_back([t]()
+                             {
+            for (int i = 0; i < MESSAGE_COUNT; ++i)
+            {
+                if (i % 2)
+                    LOG_INFO("Synchronous message {} from {}", i, t);
+                else
+                    LOG_INFO_KV("Synchronous message", "index", i, "thread", t);
+            } });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    auto logger = Logger::getInstance();
+    Logger::Metrics metrics = logger->metrics();
+    size_t lines = countLines(cfg.logDir, "Synchronous message");
+    if (lines != THREAD_COUNT * MESSAGE_COUNT)
+    {
+        std::cout << std::format("[WARNING] {} of {} messages in the file\n", lines, THREAD_COUNT * MESSAGE_COUNT);
+        passed = false;
+    }
+    if (!metrics.buffers.empty() || metrics.messagesConsumed != metrics.messagesProduced)
+    {
+        std::cout << std::format("[WARNING] {} ring buffers, {} messages produced, {} written\n",
+                                 metrics.buffers.size(), metrics.messagesProduced, metrics.messagesConsumed);
+        passed = false;
+    }
+
+    passed = logger->flush(std::chrono::seconds(1), true) && passed;
+    Logger::destroyInstance();
+
+    std::cout << std::format("[RESULT] Synchronous mode: {}\n", passed ? "PASSED" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+#include "blitz_logger.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+// renders binary (.blz) log files written with Config::binaryOutput in the regular text layout,
+// compressed files (.lz/.gz) are decompressed first, compressed text logs are printed as is
+namespace
+{
+    void printUsage(const char *program)
+    {
+        std::cerr << std::format("Usage: {} [options] <file.blz|file.log.lz|...>...\n", program)
+                  << "Options:\n"
+                  << "  --no-timestamp    omit timestamps\n"
+                  << "  --no-thread-id    omit thread ids\n"
+                  << "  --no-module       omit module names\n"
+                  << "  --no-source       omit source locations\n"
+                  << "  --full-path       show full source file paths\n"
+                  << "  --json            render JSON lines\n"
+                  << "  --logfmt          render logfmt lines\n";
+    }
+
+    bool decodeFile(const std::string &path, const Logger::Config &cfg)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << std::format("Failed to open {}\n", path);
+            return false;
+        }
+
+        std::vector<char> data;
+        try
+        {
+            std::string raw(std::istreambuf_iterator<char>(file), {});
+            data = blitz_compress::decompressAny(raw);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << std::format("{}: {}\n", path, e.what());
+            return false;
+        }
+
+        if (data.size() < blitz_binary::MAGIC.size() ||
+            !std::equal(blitz_binary::MAGIC.begin(), blitz_binary::MAGIC.end(), data.begin()))
+        {
+            std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+            return true;
+        }
+
+        std::istringstream input(std::string(data.begin(), data.end()));
+        blitz_binary::Reader reader(input);
+        blitz_binary::DecodedMessage msg;
+        std::vector<char> buffer;
+        buffer.reserve(1024 * 1024);
+
+        try
+        {
+            while (reader.next(msg))
+            {
+                Logger::formatRecord(cfg,
+                                     {static_cast<Logger::Level>(msg.level),
+                                      std::chrono::system_clock::time_point(
+                                          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                              std::chrono::nanoseconds(msg.timestampNs))),
+                                      static_cast<size_t>(msg.threadHash),
+                                      msg.module,
+                                      msg.file,
+                                      msg.line,
+                                      msg.message,
+                                      msg.fields},
+                                     buffer);
+                buffer.push_back('\n');
+
+                if (buffer.size() > 512 * 1024)
+                {
+                    std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    buffer.clear();
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            std::cerr << std::format("{}: {}\n", path, e.what());
+            return false;
+        }
+
+        std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        return true;
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    Logger::Config cfg;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--no-timestamp")
+            cfg.showTimestamp = false;
+        else if (arg == "--no-thread-id")
+            cfg.showThreadId = false;
+        else if (arg == "--no-module")
+            cfg.showModuleName = false;
+        else if (arg == "--no-source")
+            cfg.showSourceLocation = false;
+        else if (arg == "--full-path")
+            cfg.showFullPath = true;
+        else if (arg == "--json")
+            cfg.layout = Logger::Layout::JSON;
+        else if (arg == "--logfmt")
+            cfg.layout = Logger::Layout::LOGFMT;
+        else if (arg.starts_with("--"))
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        else
+            files.emplace_back(arg);
+    }
+
+    if (files.empty())
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    for (const auto &file : files)
+        ok = decodeFile(file, cfg) && ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}